@@ -0,0 +1,25 @@
+/*
+ * arena.cpp
+ * This file implements the Arena class defined in arena.h.
+ *
+ * The constructor sets up the monotonic resource whose first block is FIRST_BLOCK_SIZE bytes; each later block is larger than the last,
+ * so a big script needs few of them.
+ *
+ * The Release method runs the destructors of the objects created with New, newest first, and then hands every block back at once.
+ * The arena can be used again afterwards.
+ */
+#include "arena.h"
+
+Arena::Arena() : resource(FIRST_BLOCK_SIZE) {}
+Arena::~Arena()
+{
+    Release();
+}
+void Arena::Release()
+{
+    for (auto it = destructors.rbegin(); it != destructors.rend(); ++it)
+        it->destroy(it->object);
+    destructors.clear();
+    count = 0;
+    resource.release();
+}
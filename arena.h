@@ -0,0 +1,68 @@
+/*
+ * arena.h
+ * This file defines the Arena class, the bump-pointer allocator that owns the syntax tree of one parse.
+ *
+ * The Parser creates every Expr and Stmt node with New, which constructs it in the arena's current block instead of on the heap,
+ * and it builds the lists of the tree (block statements, function parameters and bodies, class methods, call arguments) with the
+ * arena's Resource, so their storage comes from the same blocks.
+ *
+ * Release destroys the nodes that were created, in reverse order, and then frees all the blocks in one operation. It runs when the
+ * arena is destroyed, so the tree of a parse lives exactly as long as the Arena it was parsed into. Nothing in the tree may be used
+ * after that: a function refers to its declaration in the tree.
+ *
+ * Freeing a list that lives in the arena does nothing; its storage is reclaimed with the rest of the blocks.
+ *
+ * Count returns how many objects New has created since the last Release, which is the number of nodes in the tree.
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class Arena
+{
+public:
+    Arena();
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena();
+
+    // constructs a T in the arena; it is destroyed by Release
+    template <typename T, typename... Args>
+    T *New(Args &&...args)
+    {
+        void *memory = resource.allocate(sizeof(T), alignof(T));
+        T *object = new (memory) T(std::forward<Args>(args)...);
+        count++;
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            destructors.push_back({object, [](void *pointer)
+                                   { static_cast<T *>(pointer)->~T(); }});
+        return object;
+    }
+    // the number of objects created with New
+    size_t Count() const { return count; }
+    // the memory resource for the lists of the tree
+    std::pmr::memory_resource *Resource() { return &resource; }
+    // destroys every object created with New and frees all the blocks
+    void Release();
+
+private:
+    static const size_t FIRST_BLOCK_SIZE = 16 * 1024;
+
+    struct Destructor
+    {
+        void *object;
+        void (*destroy)(void *object);
+    };
+
+    std::pmr::monotonic_buffer_resource resource;
+    std::vector<Destructor> destructors; // in the order the objects were created
+    size_t count = 0;
+};
+
+#endif // ARENA_H
@@ -1,53 +1,51 @@
 /*
  * File: ast_printer.cpp
  * ----------------------
- * This file implements the ToStringVisitor struct defined in ast_printer.h.
+ * This file implements the AstPrinter class defined in ast_printer.h.
  *
- * The ToStringVisitor struct is a visitor struct that is used to convert different types of values to strings.
- * It overloads the function call operator for different types of values.
- *
- * The operator() methods are used to convert the corresponding type of value to a string.
- * For example, the operator()(const double &value) method converts a double value to a string,
- * and the operator()(const bool &value) method converts a boolean value to a string.
+ * The LiteralToString method converts the value of a literal to a string: numbers with std::to_string, strings as they are,
+ * and nil and the booleans by name.
  *
  * This file is part of the implementation of a programming language interpreter.
  */
 #include <sstream>
 #include "ast_printer.h"
+#include "lox_string.h"
+#include "string_table.h"
 
-std::string ToStringVisitor::operator()(const double &value) const
-{
-    return std::to_string(value);
-}
-std::string ToStringVisitor::operator()(const std::string &value) const
-{
-    return value;
-}
-std::string ToStringVisitor::operator()(std::nullptr_t) const
-{
+std::string AstPrinter::LiteralToString(Object value)
+{
+    if (value.IsNumber())
+        return std::to_string(value.AsNumber());
+    if (value.IsString())
+        return value.AsString()->chars;
+    if (value.IsBool())
+        return value.AsBool() ? "true_" : "false";
     return "nil";
 }
-std::string ToStringVisitor::operator()(const bool &value) const
+Object AstPrinter::Text(const std::string &text)
 {
-    return value ? "true_" : "false";
+    return StringTable::Instance().Intern(text);
 }
-std::string ToStringVisitor::operator()(Expr *value) const
+std::string AstPrinter::TextOf(Object value)
 {
-    return "Expr";
+    return value.IsString() ? value.AsString()->chars : "";
 }
 void AstPrinter::print(Stmt *expr)
 {
-    if (std::holds_alternative<std::string>(expr->Accept(*this)))
-        std::cout << std::get<std::string>(expr->Accept(*this)) << std::endl;
+    Object text = expr->Accept(*this);
+    if (text.IsString())
+        std::cout << TextOf(text) << std::endl;
 }
 void AstPrinter::print(Expr *expr)
 {
-    if (std::holds_alternative<std::string>(expr->Accept(*this)))
-        std::cout << std::get<std::string>(expr->Accept(*this)) << std::endl;
+    Object text = expr->Accept(*this);
+    if (text.IsString())
+        std::cout << TextOf(text) << std::endl;
 }
 Object AstPrinter::VisitBinaryExpr(Binary &expr)
 {
-    return parenthesize(expr.op.lexeme, expr.left, expr.right);
+    return parenthesize(std::string(expr.op.Lexeme()), expr.left, expr.right);
 }
 Object AstPrinter::VisitGroupingExpr(Grouping &expr)
 {
@@ -55,37 +53,37 @@ Object AstPrinter::VisitGroupingExpr(Grouping &expr)
 }
 Object AstPrinter::VisitUnaryExpr(Unary &expr)
 {
-    return parenthesize(expr.op.lexeme, expr.right);
+    return parenthesize(std::string(expr.op.Lexeme()), expr.right);
 }
 Object AstPrinter::VisitLiteralExpr(Literal &expr)
 {
-    return parenthesize(std::visit(ToStringVisitor(), expr.value));
+    return parenthesize(LiteralToString(expr.value));
 }
 Object AstPrinter::VisitAssignExpr(Assign &expr)
 {
-    return parenthesize(expr.name.lexeme, expr.value);
+    return parenthesize(std::string(expr.name.Lexeme()), expr.value);
 }
 Object AstPrinter::VisitGetExpr(Get &expr)
 {
-    return parenthesize(expr.name.lexeme, expr.object);
+    return parenthesize(std::string(expr.name.Lexeme()), expr.object);
 }
 Object AstPrinter::VisitLogicalExpr(Logical &expr)
 {
-    return parenthesize(expr.op.lexeme, expr.left, expr.right);
+    return parenthesize(std::string(expr.op.Lexeme()), expr.left, expr.right);
 }
 Object AstPrinter::VisitSetExpr(Set &expr)
 {
-    return parenthesize(expr.name.lexeme, expr.value);
+    return parenthesize(std::string(expr.name.Lexeme()), expr.value);
 }
 Object AstPrinter::VisitSuperExpr(Super &expr)
 {
-    std::string ret = "Super expression " + expr.method.lexeme;
-    return ret;
+    std::string ret = "Super expression " + std::string(expr.method.Lexeme());
+    return Text(ret);
 }
 Object AstPrinter::VisitThisExpr(This &expr)
 {
-    std::string ret = "This expression " + expr.keyword.lexeme;
-    return ret;
+    std::string ret = "This expression " + std::string(expr.keyword.Lexeme());
+    return Text(ret);
 }
 Object AstPrinter::VisitCallExpr(Call &expr)
 {
@@ -93,7 +91,7 @@ Object AstPrinter::VisitCallExpr(Call &expr)
 }
 Object AstPrinter::VisitVariableExpr(Variable &expr)
 {
-    return parenthesize(expr.name.lexeme);
+    return parenthesize(std::string(expr.name.Lexeme()));
 }
 Object AstPrinter::VisitBlockStmt(Block &stmt)
 {
@@ -101,7 +99,7 @@ Object AstPrinter::VisitBlockStmt(Block &stmt)
 }
 Object AstPrinter::VisitClassStmt(Class &stmt)
 {
-    return parenthesize_fun("Class " + stmt.name.lexeme, stmt.methods);
+    return parenthesize_fun("Class " + std::string(stmt.name.Lexeme()), stmt.methods);
 }
 Object AstPrinter::VisitExpressionStmt(Expression &stmt)
 {
@@ -110,7 +108,7 @@ Object AstPrinter::VisitExpressionStmt(Expression &stmt)
 }
 Object AstPrinter::VisitFunctionStmt(Function &stmt)
 {
-    return parenthesize_fun("Fun " + stmt.name.lexeme, stmt.body);
+    return parenthesize_fun("Fun " + std::string(stmt.name.Lexeme()), stmt.body);
 }
 Object AstPrinter::VisitIfStmt(If &stmt)
 {
@@ -125,11 +123,11 @@ Object AstPrinter::VisitPrintStmt(Print &stmt)
 }
 Object AstPrinter::VisitReturnStmt(Return &stmt)
 {
-    return parenthesize(stmt.keyword.lexeme, stmt.value);
+    return parenthesize(std::string(stmt.keyword.Lexeme()), stmt.value);
 }
 Object AstPrinter::VisitVarStmt(Var &stmt)
 {
-    return parenthesize(stmt.name.lexeme, stmt.initializer);
+    return parenthesize(std::string(stmt.name.Lexeme()), stmt.initializer);
 }
 Object AstPrinter::VisitWhileStmt(While &stmt)
 {
@@ -137,36 +135,36 @@ Object AstPrinter::VisitWhileStmt(While &stmt)
 }
 
 template <typename T, typename... Args>
-std::string AstPrinter::parenthesize(const T &name, Args... expr)
+Object AstPrinter::parenthesize(const T &name, Args... expr)
 {
     std::stringstream ss;
     ss << "(" << name;
 
-    ((ss << " " << std::get<std::string>(expr->Accept(*this))), ...);
+    ((ss << " " << TextOf(expr->Accept(*this))), ...);
 
     ss << ")";
 
-    return ss.str();
+    return Text(ss.str());
 }
-std::string AstPrinter::parenthesize_fun(std::string name, const std::vector<Stmt *> &body)
+Object AstPrinter::parenthesize_fun(std::string name, const std::pmr::vector<Stmt *> &body)
 {
     std::stringstream ss;
     ss << "(" << name;
 
     for (const auto &statement : body)
-        ss << " " << std::get<std::string>(statement->Accept(*this));
+        ss << " " << TextOf(statement->Accept(*this));
 
     ss << ")";
-    return ss.str();
+    return Text(ss.str());
 }
-std::string AstPrinter::parenthesize_fun(std::string name, const std::vector<Function *> &body)
+Object AstPrinter::parenthesize_fun(std::string name, const std::pmr::vector<Function *> &body)
 {
     std::stringstream ss;
     ss << "(" << name;
 
     for (const auto &statement : body)
-        ss << " " << std::get<std::string>(statement->Accept(*this));
+        ss << " " << TextOf(statement->Accept(*this));
 
     ss << ")";
-    return ss.str();
+    return Text(ss.str());
 }
\ No newline at end of file
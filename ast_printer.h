@@ -1,15 +1,14 @@
 /*
  * File: ast_printer.h
  * -------------------
- * This file defines the AstPrinter class and the ToStringVisitor struct.
+ * This file defines the AstPrinter class.
  *
  * The AstPrinter class is a visitor class that is used to print the abstract syntax tree (AST) of a program.
  * It overrides the visit methods for each type of expression (Expr) and statement (Stmt) in the AST.
  * The print methods are used to initiate the printing process for an expression or a statement.
  * The parenthesize methods are helper methods used to format the output.
- *
- * The ToStringVisitor struct is a visitor struct that is used to convert different types of values to strings.
- * It overloads the function call operator for different types of values.
+ * Every visit method returns its text as a heap string; Text creates one and TextOf reads it back.
+ * The LiteralToString method converts the value of a literal to text.
  *
  * This file is part of the implementation of a programming language interpreter.
  */
@@ -19,15 +18,6 @@
 #include <string>
 #include "expr.h"
 
-struct ToStringVisitor
-{
-    std::string operator()(const double &value) const;
-    std::string operator()(const std::string &value) const;
-    std::string operator()(std::nullptr_t) const;
-    std::string operator()(const bool &value) const;
-    std::string operator()(Expr *value) const;
-};
-
 class AstPrinter : public Visitor
 {
 public:
@@ -58,9 +48,15 @@ private:
     Object VisitWhileStmt(While &stmt) override;
 
     template <typename T, typename... Args>
-    std::string parenthesize(const T &name, Args... expr);
-    std::string parenthesize_fun(std::string name, const std::vector<Stmt *> &body);
-    std::string parenthesize_fun(std::string name, const std::vector<Function *> &body);
+    Object parenthesize(const T &name, Args... expr);
+    Object parenthesize_fun(std::string name, const std::pmr::vector<Stmt *> &body);
+    Object parenthesize_fun(std::string name, const std::pmr::vector<Function *> &body);
+    // converts a literal value to text
+    static std::string LiteralToString(Object value);
+    // wraps text in a heap string, the value every visit method returns
+    static Object Text(const std::string &text);
+    // returns the text a visit method produced
+    static std::string TextOf(Object value);
 };
 
 #endif // AST_PRINTER_H
\ No newline at end of file
@@ -0,0 +1,402 @@
+/*
+ * frontend_bench.cpp
+ * This is the entry point of the front-end benchmark, which measures the Scanner, the Parser and the Resolver on their own.
+ *
+ * It generates synthetic Lox programs of a given size in one of several shapes:
+ *   functions - many small functions with a little arithmetic and control flow each
+ *   nested    - blocks, ifs and loops nested deeply, with parenthesised expressions
+ *   classes   - wide classes with many methods and field accesses
+ *   strings   - variables initialised with long string literals
+ *   mixed     - all of the above, interleaved
+ * Each corpus is run through the three phases several times; for each phase the fastest run is reported, with its throughput in
+ * MB/s, tokens/s and AST nodes/s and the heap allocations and bytes it made. Every corpus is generated and run in a child process of
+ * its own, so the peak resident set size reported with it is that corpus's and not the largest of the corpora run before it.
+ *
+ * The scan phase pulls every token from a Scanner, as the Parser does. The parse phase parses tokens scanned beforehand, so it
+ * does not include scanning, and the resolve phase resolves the tree just parsed. Allocations are counted by replacing the global
+ * operator new for this program, in both its plain and its aligned forms.
+ *
+ * The results are printed to stdout as one JSON object, so they can be kept and compared from one release to the next.
+ *
+ * Usage: frontend_bench [--size=<MB>] [--shape=<shape>] [--repeat=<n>]
+ * The shape may be given more than once; without it every shape is run. The size defaults to 4 MB and the repeat count to 5.
+ *
+ * The benchmark is built from the interpreter's sources without main.cpp, for example from the top of the repository:
+ *   g++ -std=c++17 -O2 -I. bench/frontend_bench.cpp $(ls *.cpp | grep -v '^main.cpp$') -lpthread -o frontend_bench
+ */
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include "scanner.h"
+#include "parser.h"
+#include "arena.h"
+#include "resolver.h"
+#include "error.h"
+
+static size_t allocations = 0;
+static size_t allocated_bytes = 0;
+
+void *operator new(size_t size)
+{
+    allocations++;
+    allocated_bytes += size;
+    if (void *memory = std::malloc(size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc();
+}
+// not inlined, so that the compiler does not mistake the free for the release of memory that came from new
+__attribute__((noinline)) void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+__attribute__((noinline)) void operator delete(void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    allocations++;
+    allocated_bytes += size;
+    size_t align = static_cast<size_t>(alignment);
+    // aligned_alloc requires a size that is a non-zero multiple of the alignment
+    size_t rounded = size == 0 ? align : (size + align - 1) / align * align;
+    if (void *memory = std::aligned_alloc(align, rounded))
+        return memory;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void *memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+__attribute__((noinline)) void operator delete(void *memory, size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+struct PhaseResult
+{
+    double seconds = 0;
+    size_t allocations = 0;
+    size_t allocated_bytes = 0;
+};
+
+struct CorpusResult
+{
+    std::string shape;
+    size_t bytes = 0;
+    size_t tokens = 0;
+    size_t nodes = 0;
+    PhaseResult scan;
+    PhaseResult parse;
+    PhaseResult resolve;
+    long peak_rss_kb = 0;
+};
+
+// measures the time and the allocations of one run of a phase
+class PhaseTimer
+{
+public:
+    PhaseTimer() : start(std::chrono::steady_clock::now()), start_allocations(allocations), start_bytes(allocated_bytes) {}
+    // keeps the run in best if it is the fastest so far
+    void Stop(PhaseResult &best, bool first)
+    {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (first || seconds < best.seconds)
+            best = PhaseResult{seconds, allocations - start_allocations, allocated_bytes - start_bytes};
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+    size_t start_allocations;
+    size_t start_bytes;
+};
+
+static void GenerateFunction(std::string &out, int n)
+{
+    std::string id = std::to_string(n);
+    out += "fun f" + id + "(a, b) {\n";
+    out += "  var x = a + b * " + id + ";\n";
+    out += "  if (x > 3 and a != b) { x = x - 1; } else { x = x + 1; }\n";
+    out += "  for (var i = 0; i < 3; i = i + 1) x = x + i;\n";
+    out += "  return x;\n";
+    out += "}\n";
+}
+
+static void GenerateNested(std::string &out, int n)
+{
+    const int depth = 32;
+    std::string indent;
+    out += "{\n";
+    for (int level = 0; level < depth; level++)
+    {
+        indent += "  ";
+        std::string v = "v" + std::to_string(level);
+        out += indent + "var " + v + " = ((" + std::to_string(n) + " + " + std::to_string(level) + ") * (2 - 1));\n";
+        if (level % 2 == 0)
+            out += indent + "if (" + v + " > 0) {\n";
+        else
+            out += indent + "while (" + v + " < 0) {\n";
+    }
+    for (int level = depth - 1; level >= 0; level--)
+    {
+        out += indent + "}\n";
+        indent.resize(indent.size() - 2);
+    }
+    out += "}\n";
+}
+
+static void GenerateClass(std::string &out, int n)
+{
+    const int methods = 48;
+    std::string id = std::to_string(n);
+    out += "class C" + id + " {\n";
+    out += "  init() { this.f0 = 0; }\n";
+    for (int m = 0; m < methods; m++)
+    {
+        std::string field = "f" + std::to_string(m);
+        out += "  m" + std::to_string(m) + "(a) { this." + field + " = a; return this." + field + " + this.f0; }\n";
+    }
+    out += "}\n";
+}
+
+static void GenerateString(std::string &out, int n)
+{
+    const size_t length = 1024;
+    std::string text;
+    while (text.size() < length)
+        text += "the quick brown fox " + std::to_string(n) + " jumps over the lazy dog; ";
+    out += "var s" + std::to_string(n) + " = \"" + text + "\";\n";
+}
+
+// generates at least size bytes of a program of the given shape, or returns false if there is no such shape
+static bool Generate(const std::string &shape, size_t size, std::string &out)
+{
+    void (*generators[])(std::string &, int) = {GenerateFunction, GenerateNested, GenerateClass, GenerateString};
+    int first = 0, count = 1;
+    if (shape == "functions")
+        first = 0;
+    else if (shape == "nested")
+        first = 1;
+    else if (shape == "classes")
+        first = 2;
+    else if (shape == "strings")
+        first = 3;
+    else if (shape == "mixed")
+        count = 4;
+    else
+        return false;
+
+    out.reserve(size + 4096);
+    for (int n = 0; out.size() < size; n++)
+        generators[first + n % count](out, n);
+    return true;
+}
+
+static CorpusResult Run(const std::string &shape, const std::string &source, int repeat)
+{
+    CorpusResult result;
+    result.shape = shape;
+    result.bytes = source.size();
+
+    for (int run = 0; run < repeat; run++)
+    {
+        bool first = run == 0;
+        size_t tokens = 0;
+        {
+            Scanner scanner(source);
+            PhaseTimer timer;
+            while (scanner.NextToken().type != END_OF_FILE)
+                tokens++;
+            timer.Stop(result.scan, first);
+        }
+        result.tokens = tokens + 1;
+
+        Scanner scanner(source);
+        scanner.ScanInParallel(1);
+        Arena arena;
+        Resolver resolver;
+
+        PhaseTimer parse_timer;
+        Parser parser(scanner, arena);
+        std::pmr::vector<Stmt *> statements = parser.Parse();
+        parse_timer.Stop(result.parse, first);
+        result.nodes = arena.Count();
+
+        PhaseTimer resolve_timer;
+        resolver.Resolve(statements);
+        resolve_timer.Stop(result.resolve, first);
+
+        if (had_error)
+        {
+            std::cerr << "The generated " << shape << " program has errors." << std::endl;
+            exit(70);
+        }
+    }
+
+    return result;
+}
+
+// writes a whole object to a pipe, and returns whether all of it was written
+static bool WriteAll(int fd, const void *data, size_t size)
+{
+    const char *bytes = static_cast<const char *>(data);
+    while (size > 0)
+    {
+        ssize_t written = write(fd, bytes, size);
+        if (written <= 0)
+            return false;
+        bytes += written;
+        size -= written;
+    }
+    return true;
+}
+// reads a whole object from a pipe, and returns whether all of it was read
+static bool ReadAll(int fd, void *data, size_t size)
+{
+    char *bytes = static_cast<char *>(data);
+    while (size > 0)
+    {
+        ssize_t count = read(fd, bytes, size);
+        if (count <= 0)
+            return false;
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+// generates and runs one corpus in a child process, and returns the exit status of the child: 0 once result is filled in
+static int RunInChild(const std::string &shape, size_t size, int repeat, CorpusResult &result)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        std::cerr << "Cannot create a pipe." << std::endl;
+        return 71;
+    }
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        std::cerr << "Cannot fork." << std::endl;
+        return 71;
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        std::string source;
+        if (!Generate(shape, size, source))
+        {
+            std::cerr << "Unknown shape: " << shape << std::endl;
+            _exit(64);
+        }
+        CorpusResult child = Run(shape, source, repeat);
+        bool sent = WriteAll(fds[1], &child.bytes, sizeof(child.bytes)) && WriteAll(fds[1], &child.tokens, sizeof(child.tokens)) &&
+                    WriteAll(fds[1], &child.nodes, sizeof(child.nodes)) && WriteAll(fds[1], &child.scan, sizeof(child.scan)) &&
+                    WriteAll(fds[1], &child.parse, sizeof(child.parse)) && WriteAll(fds[1], &child.resolve, sizeof(child.resolve));
+        _exit(sent ? 0 : 71);
+    }
+
+    close(fds[1]);
+    result.shape = shape;
+    bool received = ReadAll(fds[0], &result.bytes, sizeof(result.bytes)) && ReadAll(fds[0], &result.tokens, sizeof(result.tokens)) &&
+                    ReadAll(fds[0], &result.nodes, sizeof(result.nodes)) && ReadAll(fds[0], &result.scan, sizeof(result.scan)) &&
+                    ReadAll(fds[0], &result.parse, sizeof(result.parse)) && ReadAll(fds[0], &result.resolve, sizeof(result.resolve));
+    close(fds[0]);
+
+    int status;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    if (!WIFEXITED(status))
+        return 70;
+    if (WEXITSTATUS(status) != 0)
+        return WEXITSTATUS(status);
+    if (!received)
+        return 71;
+    result.peak_rss_kb = usage.ru_maxrss;
+    return 0;
+}
+
+static void PrintPhase(std::ostream &out, const char *name, const PhaseResult &phase, const CorpusResult &corpus, bool last)
+{
+    double seconds = phase.seconds > 0 ? phase.seconds : 1e-9;
+    out << "        \"" << name << "\": {"
+        << "\"seconds\": " << phase.seconds
+        << ", \"mb_per_s\": " << corpus.bytes / 1e6 / seconds
+        << ", \"tokens_per_s\": " << corpus.tokens / seconds
+        << ", \"nodes_per_s\": " << corpus.nodes / seconds
+        << ", \"allocations\": " << phase.allocations
+        << ", \"allocated_bytes\": " << phase.allocated_bytes
+        << "}" << (last ? "\n" : ",\n");
+}
+
+static void PrintResults(std::ostream &out, const std::vector<CorpusResult> &results, int repeat)
+{
+    out.precision(6);
+    out << "{\n";
+    out << "  \"benchmark\": \"frontend\",\n";
+    out << "  \"repeat\": " << repeat << ",\n";
+    out << "  \"corpora\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const CorpusResult &corpus = results[i];
+        out << "    {\n";
+        out << "      \"shape\": \"" << corpus.shape << "\",\n";
+        out << "      \"bytes\": " << corpus.bytes << ",\n";
+        out << "      \"tokens\": " << corpus.tokens << ",\n";
+        out << "      \"ast_nodes\": " << corpus.nodes << ",\n";
+        out << "      \"phases\": {\n";
+        PrintPhase(out, "scan", corpus.scan, corpus, false);
+        PrintPhase(out, "parse", corpus.parse, corpus, false);
+        PrintPhase(out, "resolve", corpus.resolve, corpus, true);
+        out << "      },\n";
+        out << "      \"peak_rss_kb\": " << corpus.peak_rss_kb << "\n";
+        out << "    }" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+int main(int argc, char const *argv[])
+{
+    const std::string size_flag = "--size=", shape_flag = "--shape=", repeat_flag = "--repeat=";
+    double size_mb = 4;
+    int repeat = 5;
+    std::vector<std::string> shapes;
+    for (int arg = 1; arg < argc; arg++)
+    {
+        std::string flag = argv[arg];
+        if (flag.compare(0, size_flag.size(), size_flag) == 0)
+            size_mb = std::stod(flag.substr(size_flag.size()));
+        else if (flag.compare(0, shape_flag.size(), shape_flag) == 0)
+            shapes.push_back(flag.substr(shape_flag.size()));
+        else if (flag.compare(0, repeat_flag.size(), repeat_flag) == 0)
+            repeat = std::max(1, std::stoi(flag.substr(repeat_flag.size())));
+        else
+        {
+            std::cerr << "Usage: frontend_bench [--size=<MB>] [--shape=functions|nested|classes|strings|mixed] [--repeat=<n>]" << std::endl;
+            return 64;
+        }
+    }
+    if (shapes.empty())
+        shapes = {"functions", "nested", "classes", "strings", "mixed"};
+
+    std::vector<CorpusResult> results;
+    for (const std::string &shape : shapes)
+    {
+        CorpusResult result;
+        int status = RunInChild(shape, static_cast<size_t>(size_mb * 1e6), repeat, result);
+        if (status != 0)
+            return status;
+        results.push_back(result);
+    }
+
+    PrintResults(std::cout, results, repeat);
+    return 0;
+}
@@ -0,0 +1,38 @@
+/*
+ * chunk.cpp
+ * This file implements the Chunk class defined in chunk.h.
+ *
+ * The Write method appends a byte and its source line.
+ *
+ * The AddConstant method looks the value up in the number or object index before appending it, so a chunk that mentions the same
+ * global or literal many times adds it once, and most operands keep their short 16-bit form.
+ */
+#include <cstring>
+#include "chunk.h"
+
+void Chunk::Write(uint8_t byte, int line)
+{
+    code.push_back(byte);
+    lines.push_back(line);
+}
+int Chunk::AddConstant(Value value)
+{
+    int index = static_cast<int>(constants.size());
+    if (value.IsNumber())
+    {
+        double number = value.AsNumber();
+        uint64_t bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        auto result = number_constants.emplace(bits, index);
+        if (!result.second)
+            return result.first->second;
+    }
+    else if (value.IsObj())
+    {
+        auto result = object_constants.emplace(value.AsObj(), index);
+        if (!result.second)
+            return result.first->second;
+    }
+    constants.push_back(value);
+    return index;
+}
@@ -0,0 +1,87 @@
+/*
+ * chunk.h
+ * This file defines the OpCode enum and the Chunk class, which hold the bytecode produced by the Compiler and executed by the VM.
+ *
+ * A Chunk is a flat array of bytes made of opcodes followed by their operands, a parallel array with the source line of every byte,
+ * and a constant pool. Constants and global names are addressed by 16-bit operands. An instruction whose operand does not fit in 16 bits
+ * is emitted in its wide form instead: the opcode with the OP_LONG bit set, followed by a 24-bit operand. Jumps always take 24-bit offsets,
+ * because a forward jump is emitted before the length of the code it jumps over is known.
+ *
+ * The Write method appends a byte to the chunk.
+ * The AddConstant method adds a number or object to the constant pool, reusing an existing slot for the same number or object.
+ */
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "vm_value.h"
+
+// set in the opcode of the wide form of an instruction with a constant operand, whose operand is 24 bits instead of 16
+const uint8_t OP_LONG = 0x80;
+// the largest 24-bit operand
+const uint32_t UINT24_MAX = 0xffffff;
+
+enum OpCode : uint8_t
+{
+    OP_CONSTANT,      // [u16 constant]         push a constant
+    OP_NIL,           //                        push nil
+    OP_TRUE,          //                        push true
+    OP_FALSE,         //                        push false
+    OP_POP,           //                        pop the top value
+    OP_GET_LOCAL,     // [u8 slot]              push a local of the current frame
+    OP_SET_LOCAL,     // [u8 slot]              store the top value into a local
+    OP_GET_GLOBAL,    // [u16 name]             push a global
+    OP_DEFINE_GLOBAL, // [u16 name]             pop the top value into a new global
+    OP_SET_GLOBAL,    // [u16 name]             store the top value into an existing global
+    OP_GET_UPVALUE,   // [u8 index]             push a captured variable
+    OP_SET_UPVALUE,   // [u8 index]             store the top value into a captured variable
+    OP_GET_PROPERTY,  // [u16 name]             replace an instance with one of its fields or bound methods
+    OP_SET_PROPERTY,  // [u16 name]             instance, value -> value
+    OP_GET_SUPER,     // [u16 name]             this, superclass -> bound superclass method
+    OP_EQUAL,
+    OP_NOT_EQUAL,
+    OP_GREATER,
+    OP_GREATER_EQUAL,
+    OP_LESS,
+    OP_LESS_EQUAL,
+    OP_ADD,
+    OP_SUBTRACT,
+    OP_MULTIPLY,
+    OP_DIVIDE,
+    OP_NOT,
+    OP_NEGATE,
+    OP_PRINT,
+    OP_JUMP,          // [u24 offset]           jump forward
+    OP_JUMP_IF_FALSE, // [u24 offset]           jump forward if the top value is falsey, without popping it
+    OP_LOOP,          // [u24 offset]           jump backward
+    OP_CALL,          // [u8 argc]              call the value below the arguments
+    OP_INVOKE,        // [u16 name] [u8 argc]   call a method on the receiver below the arguments
+    OP_SUPER_INVOKE,  // [u16 name] [u8 argc]   call a superclass method, the superclass is on top of the arguments
+    OP_CLOSURE,       // [u16 function] then [u8 is_local, u8 index] per upvalue
+    OP_CLOSE_UPVALUE, //                        hoist the top local into its upvalue and pop it
+    OP_RETURN,
+    OP_CLASS,         // [u16 name]             push a new class
+    OP_INHERIT,       //                        superclass, subclass -> superclass
+    OP_METHOD         // [u16 name]             class, closure -> class
+};
+
+class Chunk
+{
+public:
+    // appends a byte, remembering the source line it came from
+    void Write(uint8_t byte, int line);
+    // returns the index of value in the constant pool, adding it if needed
+    int AddConstant(Value value);
+
+    std::vector<uint8_t> code;
+    std::vector<int> lines;
+    std::vector<Value> constants;
+
+private:
+    std::unordered_map<uint64_t, int> number_constants; // keyed by bit pattern, so 0 and -0 stay distinct
+    std::unordered_map<Obj *, int> object_constants;
+};
+
+#endif // CHUNK_H
@@ -0,0 +1,548 @@
+/*
+ * compiler.cpp
+ * This file implements the Compiler class defined in compiler.h.
+ *
+ * The Resolver has already rejected invalid programs, so the Compiler only reports the bytecode limits it runs into.
+ *
+ * Every instruction that can fail at runtime is emitted with the line of the token the tree-walking Interpreter would report:
+ * the operator of a unary or binary expression, the closing parenthesis of a call, the name of a variable or property.
+ *
+ * Calls whose callee is a property access (receiver.method(args)) or a super access (super.method(args)) are compiled to
+ * OP_INVOKE and OP_SUPER_INVOKE, which call the method directly instead of creating a bound method first.
+ */
+#include "compiler.h"
+#include "error.h"
+#include "lox_string.h"
+
+Compiler::Compiler(VM *vm) : vm(vm) {}
+
+ObjFunction *Compiler::Compile(const std::pmr::vector<Stmt *> &statements)
+{
+    FunctionState script;
+    BeginFunction(script, TYPE_SCRIPT, nullptr);
+    for (Stmt *statement : statements)
+        Compile(statement);
+
+    ObjFunction *function = EndFunction();
+    return had_error ? nullptr : function;
+}
+Object Compiler::VisitAssignExpr(Assign &expr)
+{
+    Compile(expr.value);
+    line = expr.name.line;
+    NamedVariable(expr.name.Lexeme(), true);
+    return nullptr;
+}
+Object Compiler::VisitBinaryExpr(Binary &expr)
+{
+    Compile(expr.left);
+    Compile(expr.right);
+    line = expr.op.line;
+
+    switch (expr.op.type)
+    {
+    case BANG_EQUAL:
+        Emit(OP_NOT_EQUAL);
+        break;
+    case EQUAL_EQUAL:
+        Emit(OP_EQUAL);
+        break;
+    case GREATER:
+        Emit(OP_GREATER);
+        break;
+    case GREATER_EQUAL:
+        Emit(OP_GREATER_EQUAL);
+        break;
+    case LESS:
+        Emit(OP_LESS);
+        break;
+    case LESS_EQUAL:
+        Emit(OP_LESS_EQUAL);
+        break;
+    case PLUS:
+        Emit(OP_ADD);
+        break;
+    case MINUS:
+        Emit(OP_SUBTRACT);
+        break;
+    case STAR:
+        Emit(OP_MULTIPLY);
+        break;
+    case SLASH:
+        Emit(OP_DIVIDE);
+        break;
+    default:
+        break;
+    }
+    return nullptr;
+}
+Object Compiler::VisitCallExpr(Call &expr)
+{
+    if (Get *get = expr.get_callee)
+    {
+        Compile(get->object);
+        for (Expr *argument : expr.arguments)
+            Compile(argument);
+        line = expr.paren.line;
+        EmitConstantOp(OP_INVOKE, IdentifierConstant(get->name.Lexeme()));
+        Emit(static_cast<uint8_t>(expr.arguments.size()));
+        return nullptr;
+    }
+    if (Super *super = expr.super_callee)
+    {
+        line = super->keyword.line;
+        NamedVariable("this", false);
+        for (Expr *argument : expr.arguments)
+            Compile(argument);
+        NamedVariable("super", false);
+        line = expr.paren.line;
+        EmitConstantOp(OP_SUPER_INVOKE, IdentifierConstant(super->method.Lexeme()));
+        Emit(static_cast<uint8_t>(expr.arguments.size()));
+        return nullptr;
+    }
+
+    Compile(expr.callee);
+    for (Expr *argument : expr.arguments)
+        Compile(argument);
+    line = expr.paren.line;
+    Emit(OP_CALL, static_cast<uint8_t>(expr.arguments.size()));
+    return nullptr;
+}
+Object Compiler::VisitGetExpr(Get &expr)
+{
+    Compile(expr.object);
+    line = expr.name.line;
+    EmitConstantOp(OP_GET_PROPERTY, IdentifierConstant(expr.name.Lexeme()));
+    return nullptr;
+}
+Object Compiler::VisitGroupingExpr(Grouping &expr)
+{
+    Compile(expr.expression);
+    return nullptr;
+}
+Object Compiler::VisitLiteralExpr(Literal &expr)
+{
+    if (expr.value.IsNumber())
+        EmitConstantOp(OP_CONSTANT, MakeConstant(Value::Number(expr.value.AsNumber())));
+    else if (expr.value.IsString())
+        EmitConstantOp(OP_CONSTANT, MakeConstant(Value::FromObj(vm->CopyString(expr.value.AsString()->chars))));
+    else if (expr.value.IsBool())
+        Emit(expr.value.AsBool() ? OP_TRUE : OP_FALSE);
+    else
+        Emit(OP_NIL);
+    return nullptr;
+}
+Object Compiler::VisitLogicalExpr(Logical &expr)
+{
+    Compile(expr.left);
+    if (expr.op.type == OR)
+    {
+        int else_jump = EmitJump(OP_JUMP_IF_FALSE);
+        int end_jump = EmitJump(OP_JUMP);
+        PatchJump(else_jump);
+        Emit(OP_POP);
+        Compile(expr.right);
+        PatchJump(end_jump);
+    }
+    else
+    {
+        int end_jump = EmitJump(OP_JUMP_IF_FALSE);
+        Emit(OP_POP);
+        Compile(expr.right);
+        PatchJump(end_jump);
+    }
+    return nullptr;
+}
+Object Compiler::VisitSetExpr(Set &expr)
+{
+    Compile(expr.object);
+    Compile(expr.value);
+    line = expr.name.line;
+    EmitConstantOp(OP_SET_PROPERTY, IdentifierConstant(expr.name.Lexeme()));
+    return nullptr;
+}
+Object Compiler::VisitSuperExpr(Super &expr)
+{
+    line = expr.keyword.line;
+    NamedVariable("this", false);
+    NamedVariable("super", false);
+    line = expr.method.line;
+    EmitConstantOp(OP_GET_SUPER, IdentifierConstant(expr.method.Lexeme()));
+    return nullptr;
+}
+Object Compiler::VisitThisExpr(This &expr)
+{
+    line = expr.keyword.line;
+    NamedVariable("this", false);
+    return nullptr;
+}
+Object Compiler::VisitUnaryExpr(Unary &expr)
+{
+    Compile(expr.right);
+    line = expr.op.line;
+    Emit(expr.op.type == MINUS ? OP_NEGATE : OP_NOT);
+    return nullptr;
+}
+Object Compiler::VisitVariableExpr(Variable &expr)
+{
+    line = expr.name.line;
+    NamedVariable(expr.name.Lexeme(), false);
+    return nullptr;
+}
+Object Compiler::VisitBlockStmt(Block &stmt)
+{
+    BeginScope();
+    for (Stmt *statement : stmt.statements)
+        Compile(statement);
+    EndScope();
+    return nullptr;
+}
+Object Compiler::VisitClassStmt(Class &stmt)
+{
+    line = stmt.name.line;
+    uint32_t name_constant = IdentifierConstant(stmt.name.Lexeme());
+    DeclareVariable(stmt.name);
+    EmitConstantOp(OP_CLASS, name_constant);
+    DefineVariable(stmt.name);
+
+    ClassState class_state{current_class, false};
+    current_class = &class_state;
+
+    if (stmt.superclass != nullptr)
+    {
+        Compile(stmt.superclass);
+        BeginScope();
+        AddLocal("super");
+        MarkInitialized();
+        NamedVariable(stmt.name.Lexeme(), false);
+        line = stmt.superclass->name.line;
+        Emit(OP_INHERIT);
+        class_state.has_superclass = true;
+    }
+
+    NamedVariable(stmt.name.Lexeme(), false);
+    for (Function *method : stmt.methods)
+    {
+        FunctionType type = method->name.Lexeme() == "init" ? TYPE_INITIALIZER : TYPE_METHOD;
+        CompileFunction(*method, type);
+        EmitConstantOp(OP_METHOD, IdentifierConstant(method->name.Lexeme()));
+    }
+    Emit(OP_POP);
+
+    if (class_state.has_superclass)
+        EndScope();
+    current_class = class_state.enclosing;
+    return nullptr;
+}
+Object Compiler::VisitExpressionStmt(Expression &stmt)
+{
+    Compile(stmt.expression);
+    Emit(OP_POP);
+    return nullptr;
+}
+Object Compiler::VisitFunctionStmt(Function &stmt)
+{
+    line = stmt.name.line;
+    DeclareVariable(stmt.name);
+    MarkInitialized();
+    CompileFunction(stmt, TYPE_FUNCTION);
+    DefineVariable(stmt.name);
+    return nullptr;
+}
+Object Compiler::VisitIfStmt(If &stmt)
+{
+    Compile(stmt.condition);
+    int then_jump = EmitJump(OP_JUMP_IF_FALSE);
+    Emit(OP_POP);
+    Compile(stmt.thenBranch);
+    int else_jump = EmitJump(OP_JUMP);
+    PatchJump(then_jump);
+    Emit(OP_POP);
+    if (stmt.elseBranch != nullptr)
+        Compile(stmt.elseBranch);
+    PatchJump(else_jump);
+    return nullptr;
+}
+Object Compiler::VisitPrintStmt(Print &stmt)
+{
+    Compile(stmt.expression);
+    Emit(OP_PRINT);
+    return nullptr;
+}
+Object Compiler::VisitReturnStmt(Return &stmt)
+{
+    line = stmt.keyword.line;
+    if (stmt.value == nullptr)
+    {
+        EmitReturn();
+        return nullptr;
+    }
+    Compile(stmt.value);
+    Emit(OP_RETURN);
+    return nullptr;
+}
+Object Compiler::VisitVarStmt(Var &stmt)
+{
+    line = stmt.name.line;
+    DeclareVariable(stmt.name);
+    if (stmt.initializer != nullptr)
+        Compile(stmt.initializer);
+    else
+        Emit(OP_NIL);
+    DefineVariable(stmt.name);
+    return nullptr;
+}
+Object Compiler::VisitWhileStmt(While &stmt)
+{
+    int loop_start = static_cast<int>(current->function->chunk.code.size());
+    Compile(stmt.condition);
+    int exit_jump = EmitJump(OP_JUMP_IF_FALSE);
+    Emit(OP_POP);
+    Compile(stmt.body);
+    EmitLoop(loop_start);
+    PatchJump(exit_jump);
+    Emit(OP_POP);
+    return nullptr;
+}
+
+void Compiler::Compile(Stmt *stmt)
+{
+    stmt->Accept(*this);
+}
+void Compiler::Compile(Expr *expr)
+{
+    expr->Accept(*this);
+}
+void Compiler::BeginFunction(FunctionState &state, FunctionType type, const Token *name)
+{
+    state.enclosing = current;
+    state.function = vm->NewFunction();
+    state.type = type;
+    if (name != nullptr)
+        state.function->name = vm->CopyString(name->Lexeme());
+    current = &state;
+
+    // slot zero holds the receiver in methods and the callee itself in functions
+    AddLocal(type == TYPE_METHOD || type == TYPE_INITIALIZER ? "this" : "");
+    state.locals.back().depth = 0;
+}
+ObjFunction *Compiler::EndFunction()
+{
+    EmitReturn();
+    ObjFunction *function = current->function;
+    function->upvalue_count = static_cast<int>(current->upvalues.size());
+    current = current->enclosing;
+    return function;
+}
+void Compiler::CompileFunction(Function &declaration, FunctionType type)
+{
+    FunctionState state;
+    BeginFunction(state, type, &declaration.name);
+    BeginScope();
+    for (const Token &param : declaration.params)
+    {
+        DeclareVariable(param);
+        DefineVariable(param);
+    }
+    state.function->arity = static_cast<int>(declaration.params.size());
+    for (Stmt *statement : declaration.body)
+        Compile(statement);
+
+    ObjFunction *function = EndFunction();
+    line = declaration.name.line;
+    EmitConstantOp(OP_CLOSURE, MakeConstant(Value::FromObj(function)));
+    for (const Upvalue &upvalue : state.upvalues)
+    {
+        Emit(upvalue.is_local ? 1 : 0);
+        Emit(upvalue.index);
+    }
+}
+void Compiler::BeginScope()
+{
+    current->scope_depth++;
+}
+void Compiler::EndScope()
+{
+    current->scope_depth--;
+    std::vector<Local> &locals = current->locals;
+    while (!locals.empty() && locals.back().depth > current->scope_depth)
+    {
+        Emit(locals.back().is_captured ? OP_CLOSE_UPVALUE : OP_POP);
+        locals.pop_back();
+    }
+}
+
+void Compiler::Emit(uint8_t byte)
+{
+    current->function->chunk.Write(byte, line);
+}
+void Compiler::Emit(uint8_t op, uint8_t operand)
+{
+    Emit(op);
+    Emit(operand);
+}
+void Compiler::EmitShort(uint8_t op, uint16_t operand)
+{
+    Emit(op);
+    Emit(static_cast<uint8_t>(operand >> 8));
+    Emit(static_cast<uint8_t>(operand & 0xff));
+}
+void Compiler::EmitConstantOp(uint8_t op, uint32_t constant)
+{
+    if (constant <= UINT16_MAX)
+    {
+        EmitShort(op, static_cast<uint16_t>(constant));
+        return;
+    }
+    Emit(op | OP_LONG);
+    EmitLong(constant);
+}
+void Compiler::EmitLong(uint32_t operand)
+{
+    Emit(static_cast<uint8_t>((operand >> 16) & 0xff));
+    Emit(static_cast<uint8_t>((operand >> 8) & 0xff));
+    Emit(static_cast<uint8_t>(operand & 0xff));
+}
+void Compiler::EmitReturn()
+{
+    if (current->type == TYPE_INITIALIZER)
+        Emit(OP_GET_LOCAL, 0);
+    else
+        Emit(OP_NIL);
+    Emit(OP_RETURN);
+}
+int Compiler::EmitJump(uint8_t op)
+{
+    Emit(op);
+    EmitLong(UINT24_MAX);
+    return static_cast<int>(current->function->chunk.code.size()) - 3;
+}
+void Compiler::PatchJump(int offset)
+{
+    std::vector<uint8_t> &code = current->function->chunk.code;
+    int jump = static_cast<int>(code.size()) - offset - 3;
+    if (jump > static_cast<int>(UINT24_MAX))
+        ReportError("Too much code to jump over.");
+
+    code[offset] = static_cast<uint8_t>((jump >> 16) & 0xff);
+    code[offset + 1] = static_cast<uint8_t>((jump >> 8) & 0xff);
+    code[offset + 2] = static_cast<uint8_t>(jump & 0xff);
+}
+void Compiler::EmitLoop(int loop_start)
+{
+    int offset = static_cast<int>(current->function->chunk.code.size()) - loop_start + 4;
+    if (offset > static_cast<int>(UINT24_MAX))
+        ReportError("Loop body too large.");
+    Emit(OP_LOOP);
+    EmitLong(static_cast<uint32_t>(offset));
+}
+uint32_t Compiler::MakeConstant(Value value)
+{
+    int constant = current->function->chunk.AddConstant(value);
+    if (constant > static_cast<int>(UINT24_MAX))
+    {
+        if (!current->too_many_constants)
+            ReportError("Too many constants in one chunk.");
+        current->too_many_constants = true;
+        return 0;
+    }
+    return static_cast<uint32_t>(constant);
+}
+uint32_t Compiler::IdentifierConstant(std::string_view name)
+{
+    return MakeConstant(Value::FromObj(vm->CopyString(name)));
+}
+
+void Compiler::NamedVariable(std::string_view name, bool assign)
+{
+    int arg = ResolveLocal(current, name);
+    if (arg != -1)
+    {
+        Emit(assign ? OP_SET_LOCAL : OP_GET_LOCAL, static_cast<uint8_t>(arg));
+        return;
+    }
+    arg = ResolveUpvalue(current, name);
+    if (arg != -1)
+    {
+        Emit(assign ? OP_SET_UPVALUE : OP_GET_UPVALUE, static_cast<uint8_t>(arg));
+        return;
+    }
+    EmitConstantOp(assign ? OP_SET_GLOBAL : OP_GET_GLOBAL, IdentifierConstant(name));
+}
+void Compiler::DeclareVariable(const Token &name)
+{
+    if (current->scope_depth == 0)
+        return;
+    AddLocal(name.Lexeme());
+}
+void Compiler::AddLocal(std::string_view name)
+{
+    if (current->locals.size() > UINT8_MAX)
+    {
+        ReportError("Too many local variables in function.");
+        return;
+    }
+    current->locals.push_back(Local{name, -1, false});
+}
+void Compiler::MarkInitialized()
+{
+    if (current->scope_depth == 0)
+        return;
+    current->locals.back().depth = current->scope_depth;
+}
+void Compiler::DefineVariable(const Token &name)
+{
+    if (current->scope_depth > 0)
+    {
+        MarkInitialized();
+        return;
+    }
+    EmitConstantOp(OP_DEFINE_GLOBAL, IdentifierConstant(name.Lexeme()));
+}
+int Compiler::ResolveLocal(FunctionState *state, std::string_view name)
+{
+    for (int i = static_cast<int>(state->locals.size()) - 1; i >= 0; i--)
+    {
+        if (state->locals[i].name == name)
+            return i;
+    }
+    return -1;
+}
+int Compiler::ResolveUpvalue(FunctionState *state, std::string_view name)
+{
+    if (state->enclosing == nullptr)
+        return -1;
+
+    int local = ResolveLocal(state->enclosing, name);
+    if (local != -1)
+    {
+        state->enclosing->locals[local].is_captured = true;
+        return AddUpvalue(state, static_cast<uint8_t>(local), true);
+    }
+
+    int upvalue = ResolveUpvalue(state->enclosing, name);
+    if (upvalue != -1)
+        return AddUpvalue(state, static_cast<uint8_t>(upvalue), false);
+
+    return -1;
+}
+int Compiler::AddUpvalue(FunctionState *state, uint8_t index, bool is_local)
+{
+    std::vector<Upvalue> &upvalues = state->upvalues;
+    for (size_t i = 0; i < upvalues.size(); i++)
+    {
+        if (upvalues[i].index == index && upvalues[i].is_local == is_local)
+            return static_cast<int>(i);
+    }
+    if (upvalues.size() > UINT8_MAX)
+    {
+        ReportError("Too many closure variables in function.");
+        return 0;
+    }
+    upvalues.push_back(Upvalue{index, is_local});
+    return static_cast<int>(upvalues.size() - 1);
+}
+void Compiler::ReportError(const std::string &message)
+{
+    Error::ReportError(line, message);
+}
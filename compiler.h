@@ -0,0 +1,130 @@
+/*
+ * compiler.h
+ * This file defines the Compiler class, which turns a resolved list of statements into bytecode for the VM.
+ * The Compiler is a Visitor: every Visit... method emits the instructions for one kind of expression or statement.
+ *
+ * Locals live in stack slots numbered at compile time, variables captured by an inner function become upvalues,
+ * and everything declared at the top level is a global looked up by name.
+ *
+ * The Compile method returns the function holding the top-level script, or nullptr if the program exceeds one of the
+ * bytecode limits (256 locals or upvalues per function, 16777216 constants per chunk, 16777215 bytes per jump). The constant
+ * limit is reported once per function, however many constants are left over.
+ */
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "expr.h"
+#include "vm.h"
+
+class Compiler : public Visitor
+{
+public:
+    Compiler(VM *vm);
+    // compiles a resolved program into its top-level script function
+    ObjFunction *Compile(const std::pmr::vector<Stmt *> &statements);
+
+private:
+    enum FunctionType
+    {
+        TYPE_FUNCTION,
+        TYPE_INITIALIZER,
+        TYPE_METHOD,
+        TYPE_SCRIPT
+    };
+    struct Local
+    {
+        std::string_view name;
+        int depth;        // the scope depth, or -1 while the variable's initializer is being compiled
+        bool is_captured; // whether an inner function closes over it
+    };
+    struct Upvalue
+    {
+        uint8_t index;
+        bool is_local; // whether index is a local slot of the enclosing function or one of its upvalues
+    };
+    // the state of one function being compiled; functions nest like the source does
+    struct FunctionState
+    {
+        FunctionState *enclosing;
+        ObjFunction *function;
+        FunctionType type;
+        std::vector<Local> locals;
+        std::vector<Upvalue> upvalues;
+        int scope_depth = 0;
+        bool too_many_constants = false; // whether the constant limit has been reported already
+    };
+    struct ClassState
+    {
+        ClassState *enclosing;
+        bool has_superclass;
+    };
+
+    VM *vm;
+    FunctionState *current = nullptr;
+    ClassState *current_class = nullptr;
+    int line = 0; // the source line of the instructions being emitted
+
+    // visitor methods
+    Object VisitAssignExpr(Assign &expr) override;
+    Object VisitBinaryExpr(Binary &expr) override;
+    Object VisitCallExpr(Call &expr) override;
+    Object VisitGetExpr(Get &expr) override;
+    Object VisitGroupingExpr(Grouping &expr) override;
+    Object VisitLiteralExpr(Literal &expr) override;
+    Object VisitLogicalExpr(Logical &expr) override;
+    Object VisitSetExpr(Set &expr) override;
+    Object VisitSuperExpr(Super &expr) override;
+    Object VisitThisExpr(This &expr) override;
+    Object VisitUnaryExpr(Unary &expr) override;
+    Object VisitVariableExpr(Variable &expr) override;
+
+    Object VisitBlockStmt(Block &stmt) override;
+    Object VisitClassStmt(Class &stmt) override;
+    Object VisitExpressionStmt(Expression &stmt) override;
+    Object VisitFunctionStmt(Function &stmt) override;
+    Object VisitIfStmt(If &stmt) override;
+    Object VisitPrintStmt(Print &stmt) override;
+    Object VisitReturnStmt(Return &stmt) override;
+    Object VisitVarStmt(Var &stmt) override;
+    Object VisitWhileStmt(While &stmt) override;
+
+    void Compile(Stmt *stmt);
+    void Compile(Expr *expr);
+    void BeginFunction(FunctionState &state, FunctionType type, const Token *name);
+    ObjFunction *EndFunction();
+    // compiles a function body and emits the OP_CLOSURE that creates it at runtime
+    void CompileFunction(Function &declaration, FunctionType type);
+    void BeginScope();
+    void EndScope();
+
+    void Emit(uint8_t byte);
+    void Emit(uint8_t op, uint8_t operand);
+    void EmitShort(uint8_t op, uint16_t operand);
+    // emits an instruction with a constant operand, in its wide form if the operand does not fit in 16 bits
+    void EmitConstantOp(uint8_t op, uint32_t constant);
+    void EmitLong(uint32_t operand);
+    void EmitReturn();
+    // emits a forward jump with a placeholder offset and returns where to patch it
+    int EmitJump(uint8_t op);
+    void PatchJump(int offset);
+    void EmitLoop(int loop_start);
+    uint32_t MakeConstant(Value value);
+    uint32_t IdentifierConstant(std::string_view name);
+
+    // emits a read of the named variable, or a write of the value on top of the stack
+    void NamedVariable(std::string_view name, bool assign);
+    void DeclareVariable(const Token &name);
+    void AddLocal(std::string_view name);
+    void MarkInitialized();
+    // binds the value on top of the stack to a just-declared variable
+    void DefineVariable(const Token &name);
+    int ResolveLocal(FunctionState *state, std::string_view name);
+    int ResolveUpvalue(FunctionState *state, std::string_view name);
+    int AddUpvalue(FunctionState *state, uint8_t index, bool is_local);
+    void ReportError(const std::string &message);
+};
+
+#endif // COMPILER_H
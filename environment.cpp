@@ -1,107 +1,50 @@
 /*
  * environment.cpp
  * This file implements the Environment class defined in environment.h.
- * The Environment class is used to store and manage variables in the Lox language.
+ * The Environment class is used to store and manage the global variables in the Lox language.
  *
- * The constructors initialize the environment with an optional enclosing environment.
+ * The Resize method grows the values array, filling the new slots with Object::Undefined; it never shrinks it.
  *
- * The destructor deletes the enclosing environment and the values of the variables in the environment.
+ * The Define method defines a global by symbol, replacing any previous definition. It grows the array itself if the symbol has no slot yet.
  *
- * The Get method takes a token representing a variable's name and returns the variable's value. If the variable is not found in the environment, it looks for the variable in the enclosing environment. If the variable is still not found, it throws a RuntimeError.
+ * The Assign method takes a token representing a global's name and a value, and assigns the value to the global. If the global is undefined, it throws a RuntimeError.
  *
- * The GetAt method takes a distance and a variable's name, and returns the variable's value from the ancestor environment at the given distance.
+ * The ThrowUndefined method throws the RuntimeError of a read or an assignment of an undefined global; Get, which is inlined, calls it so that its fast path stays small.
  *
- * The Define method takes a variable's name and a value, and defines the variable in the environment with the given value.
- *
- * The Assign method takes a token representing a variable's name and a value, and assigns the value to the variable in the environment. If the variable is not found in the environment, it looks for the variable in the enclosing environment. If the variable is still not found, it throws a RuntimeError.
- *
- * The AssignAt method takes a distance, a token representing a variable's name, and a value, and assigns the value to the variable in the ancestor environment at the given distance.
- *
- * The Ancestor method takes a distance and returns the ancestor environment at the given distance.
- *
- * The Get_enclosing and Set_enclosing methods are used to get and set the enclosing environment.
- *
- * The values map stores the values of the variables in the environment.
+ * The Trace method marks every value held by a slot. The Size method counts every slot the values array has room for.
  */
 #include <iostream>
 #include "environment.h"
 #include "error.h"
 
-Environment::Environment()
-{
-    this->enclosing = nullptr;
-}
-Environment::Environment(Environment *enclosing)
+void Environment::Resize(size_t symbols)
 {
-    this->enclosing = enclosing;
+    if (symbols > values.size())
+        values.resize(symbols, Object::Undefined());
 }
-Environment::~Environment()
-{
-    // delete enclosing; //may cause double free
-    for (auto it = values.begin(); it != values.end(); it++)
-    {
-        std::visit([](auto &&arg)
-                   { using T = std::decay_t<decltype(arg)>;
-                    if constexpr (std::is_pointer_v<T>)
-                    {
-                        delete arg;
-                    } },
-                   it->second);
-    }
-}
-Object Environment::Get(Token name)
-{
-    if (values.find(name.lexeme) != values.end())
-    {
-        return values[name.lexeme];
-    }
-    if (enclosing != nullptr)
-        return enclosing->Get(name);
-    throw RuntimeError(name, "Undefined variable '" + name.lexeme + "'.");
-}
-Object Environment::GetAt(int distance, std::string name)
-{
-    return Ancestor(distance)->values[name];
-}
-void Environment::Define(const std::string &name, Object value)
+void Environment::Define(Symbol name, Object value)
 {
+    if (name >= values.size())
+        Resize(name + 1);
     values[name] = value;
 }
 void Environment::Assign(const Token &name, Object value)
 {
-    auto it = values.find(name.lexeme);
-    if (it != values.end())
-    {
-        it->second = value;
-        return;
-    }
-    if (enclosing != nullptr)
-    {
-        enclosing->Assign(name, value);
-        return;
-    }
-    throw RuntimeError(name, "Undefined variable '" + name.lexeme + "'.");
+    Object &slot = values[name.symbol];
+    if (slot.IsUndefined())
+        ThrowUndefined(name);
+    slot = value;
 }
-void Environment::AssignAt(int distance, Token name, Object value)
+void Environment::ThrowUndefined(const Token &name)
 {
-    Ancestor(distance)->values[name.lexeme] = value;
+    throw RuntimeError(name, "Undefined variable '" + std::string(name.Lexeme()) + "'.");
 }
-Environment *Environment::Ancestor(int distance)
+void Environment::Trace(GarbageCollector &gc)
 {
-    Environment *environment = this;
-    for (int i = 0; i < distance; i++)
-    {
-        environment = environment->enclosing;
-    }
-
-    return environment;
+    for (const Object &value : values)
+        gc.MarkValue(value);
 }
-Environment *Environment::Get_enclosing()
+size_t Environment::Size() const
 {
-    return enclosing;
+    return sizeof(Environment) + values.capacity() * sizeof(Object);
 }
-Environment *Environment::Set_enclosing(Environment *enclosing)
-{
-    this->enclosing = enclosing;
-    return enclosing;
-}
\ No newline at end of file
@@ -1,61 +1,59 @@
 /*
  * Environment.h
- * This file defines the Environment class, which is used to store and manage variables in the Lox language.
- * The Environment class provides methods for getting a variable's value, defining a variable, assigning a value to a variable, and managing enclosing environments.
+ * This file defines the Environment class, which is used to store and manage the global variables in the Lox language.
+ * The Environment class provides methods for getting a global's value, defining a global, and assigning a value to a global.
  *
- * The constructor initializes the environment with an optional enclosing environment.
+ * Globals live in the values array, at the index of the symbol of their name: symbols are dense and stable for the whole process, so
+ * the Scanner has already resolved every global name to its slot. A slot holds Object::Undefined until its global is defined, which
+ * lets a function refer to a global declared after it. Locals do not live in an Environment: they live in the slots of their function's
+ * frame on the interpreter's value stack, and captured locals in upvalues (see lox_upvalue.h).
  *
- * The destructor deletes the environment.
+ * The Resize method makes room for the globals of the given number of symbols. Every symbol of a program must have its slot before the
+ * program runs, so that reading a global is a single indexed load.
  *
- * The Get method takes a token representing a variable's name and returns the variable's value. If the variable is not found, it throws a RuntimeError.
+ * The Get method takes a token representing a global's name and returns the global's value. If the variable is not defined, it throws a RuntimeError.
  *
- * The GetAt method takes a distance and a variable's name, and returns the variable's value from the ancestor environment at the given distance.
+ * The Define method defines a global with the given name.
  *
- * The Define method takes a variable's name and a value, and defines the variable in the environment with the given value.
+ * The Assign method takes a token representing a global's name and a value, and assigns the value to the global. If the variable is not defined, it throws a RuntimeError.
  *
- * The Assign method takes a token representing a variable's name and a value, and assigns the value to the variable in the environment. If the variable is not found, it throws a RuntimeError.
- *
- * The AssignAt method takes a distance, a token representing a variable's name, and a value, and assigns the value to the variable in the ancestor environment at the given distance.
- *
- * The Ancestor method takes a distance and returns the ancestor environment at the given distance.
- *
- * The Get_enclosing and Set_enclosing methods are used to get and set the enclosing environment.
- *
- * The values map stores the values of the variables in the environment.
+ * Environments are owned by the garbage collector. The Trace method marks every value stored in the environment, and the Size method
+ * counts the slots.
  */
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
 
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include "token.h"
+#include "garbage_collector.h"
 
-class Environment
+class Environment : public GcObject
 {
 public:
-    Environment();
-    Environment(Environment *enclosing); // initializes the environment with an optional enclosing environment.
-    ~Environment();                      // deletes the environment.
-
-    // takes a token representing a variable's name and returns the variable's value. If the variable is not found, it throws a RuntimeError.
-    Object Get(Token name);
-    // takes a distance and a variable's name, and returns the variable's value from the ancestor environment at the given distance.
-    Object GetAt(int distance, std::string name);
-    // takes a variable's name and a value, and defines the variable in the environment with the given value.
-    void Define(const std::string &name, Object value);
-    // takes a token representing a variable's name and a value, and assigns the value to the variable in the environment. If the variable is not found, it throws a RuntimeError.
+    // makes room for the globals of the given number of symbols.
+    void Resize(size_t symbols);
+    // takes a token representing a global's name and returns the global's value. If the variable is not defined, it throws a RuntimeError.
+    Object Get(const Token &name)
+    {
+        Object value = values[name.symbol];
+        if (value.IsUndefined())
+            ThrowUndefined(name);
+        return value;
+    }
+    // takes a global's symbol and a value, and defines the global with the given value.
+    void Define(Symbol name, Object value);
+    // takes a token representing a global's name and a value, and assigns the value to the global. If the variable is not defined, it throws a RuntimeError.
     void Assign(const Token &name, Object value);
-    // takes a distance, a token representing a variable's name, and a value, and assigns the value to the variable in the ancestor environment at the given distance.
-    void AssignAt(int distance, Token name, Object value);
-    // takes a distance and returns the ancestor environment at the given distance.
-    Environment *Ancestor(int distance);
-    // used to get and set the enclosing environment.
-    Environment *Get_enclosing();
-    Environment *Set_enclosing(Environment *enclosing);
+    // marks the values of the variables.
+    void Trace(GarbageCollector &gc) override;
+    // returns the bytes of the environment and its slots.
+    size_t Size() const override;
 
 private:
-    Environment *enclosing;
-    std::unordered_map<std::string, Object> values;
+    std::vector<Object> values; // globals, by symbol
+
+    [[noreturn]] static void ThrowUndefined(const Token &name);
 };
 
-#endif // ENVIRONMENT_H
\ No newline at end of file
+#endif // ENVIRONMENT_H
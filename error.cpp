@@ -29,7 +29,7 @@ void Error::ReportError(Token token, std::string message)
     }
     else
     {
-        Report(token.line, " at '" + token.lexeme + "'", message);
+        Report(token.line, " at '" + std::string(token.Lexeme()) + "'", message);
     }
 }
 void Error::ProcessRuntimeError(RuntimeError error)
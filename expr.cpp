@@ -20,7 +20,8 @@ Object Assign::Accept(Visitor &visitor) { return visitor.VisitAssignExpr(*this);
 Binary::Binary(Expr *left, Token op, Expr *right) : left(left), op(op), right(right) {}
 Object Binary::Accept(Visitor &visitor) { return visitor.VisitBinaryExpr(*this); }
 
-Call::Call(Expr *callee, Token paren, std::vector<Expr *> arguments) : callee(callee), paren(paren), arguments(arguments) {}
+Call::Call(Expr *callee, Token paren, std::pmr::vector<Expr *> arguments)
+    : callee(callee), paren(paren), arguments(std::move(arguments)), get_callee(dynamic_cast<Get *>(callee)), super_callee(dynamic_cast<Super *>(callee)) {}
 Object Call::Accept(Visitor &visitor) { return visitor.VisitCallExpr(*this); }
 
 Get::Get(Expr *object, Token name) : object(object), name(name) {}
@@ -50,13 +51,15 @@ Object Unary::Accept(Visitor &visitor) { return visitor.VisitUnaryExpr(*this); }
 Variable::Variable(Token name) : name(name) {}
 Object Variable::Accept(Visitor &visitor) { return visitor.VisitVariableExpr(*this); }
 
-Block::Block(std::vector<Stmt *> statements) : statements(statements) {}
+Block::Block(std::pmr::vector<Stmt *> statements) : statements(std::move(statements)) {}
 Object Block::Accept(Visitor &visitor) { return visitor.VisitBlockStmt(*this); }
 
-Function::Function(Token name, std::vector<Token> &params, std::vector<Stmt *> &body) : name(name), params(params), body(body) {}
+Function::Function(Token name, std::pmr::vector<Token> params, std::pmr::vector<Stmt *> body)
+    : name(name), params(std::move(params)), body(std::move(body)), upvalues(this->body.get_allocator()) {}
 Object Function::Accept(Visitor &visitor) { return visitor.VisitFunctionStmt(*this); }
 
-Class::Class(Token name, Variable *superclass, std::vector<Function *> &methods) : name(name), superclass(superclass), methods(methods) {}
+Class::Class(Token name, Variable *superclass, std::pmr::vector<Function *> methods)
+    : name(name), superclass(superclass), methods(std::move(methods)) {}
 Object Class::Accept(Visitor &visitor) { return visitor.VisitClassStmt(*this); }
 
 Expression::Expression(Expr *expression) : expression(expression) {}
@@ -11,27 +11,68 @@
  * The Block, Function, Class, Expression, If, Print, Return, Var, and While classes are derived from the Stmt class. They represent different types of statements in the Lox language. Each class has a constructor that initializes the statement with its components, and an Accept method that accepts a visitor.
  *
  * The Visitor class is a base class for all visitor classes. It has a virtual Visit... method for each type of expression and statement. These methods take an expression or statement and return an object.
+ *
+ * The Assign, Super, This and Variable classes carry the Binding the Resolver found for the variable they refer to: a local of the running
+ * function, by its slot in the function's frame, an upvalue of the running closure, by its index, or a global, by the symbol of its name.
+ * A Function carries the list of variables it captures when it is created (see Capture), which the Resolver fills, and a Block the
+ * number of locals it declares.
+ *
+ * The Get and Set classes carry the inline cache of their property access (see property_cache.h).
+ * A Call records whether its callee is a Get or a Super expression, so method calls can be recognised without inspecting the callee again.
+ *
+ * The nodes are created in the Arena of the parse (see arena.h), and so is the storage of their lists; the constructors take the lists
+ * by value so the Parser can move them in without copying them out of the arena. Since a Token owns nothing, a node without a list is
+ * trivially destructible and the arena does not have to destroy it. Nodes are never copied after parsing: a LoxFunction points at
+ * its declaration in the arena instead of keeping a copy.
  */
 #ifndef EXPR_H
 #define EXPR_H
 
+#include <memory_resource>
 #include <vector>
 #include "token.h"
+#include "property_cache.h"
 #include <iostream>
 
 class Visitor;
+class Get;
+class Super;
+
+// where a variable lives at runtime, as the Resolver found it
+struct Binding
+{
+  enum Kind
+  {
+    GLOBAL, // in the global table, at the symbol of its name
+    LOCAL,  // index is the slot in the frame of the running function
+    UPVALUE // index is the upvalue of the running closure
+  };
+  Kind kind = GLOBAL;
+  int index = 0;
+};
+
+// a variable a function captures when it is created: a slot of the enclosing function's frame, or an upvalue of the enclosing closure
+struct Capture
+{
+  bool is_local;
+  int index;
+};
 
 class Expr
 {
 public:
-  virtual ~Expr() {}
   virtual Object Accept(Visitor &visitor) = 0;
+
+protected:
+  ~Expr() = default; // nodes are destroyed by their Arena, never through a base pointer
 };
 class Stmt
 {
 public:
-  virtual ~Stmt(){};
   virtual Object Accept(Visitor &visitor) = 0;
+
+protected:
+  ~Stmt() = default;
 };
 class Assign : public Expr
 {
@@ -41,6 +82,7 @@ public:
 
   Token name;
   Expr *value;
+  Binding binding;
 };
 
 class Binary : public Expr
@@ -57,12 +99,14 @@ public:
 class Call : public Expr
 {
 public:
-  Call(Expr *callee, Token paren, std::vector<Expr *> arguments);
+  Call(Expr *callee, Token paren, std::pmr::vector<Expr *> arguments);
   Object Accept(Visitor &visitor) override;
 
   Expr *callee;
   Token paren;
-  std::vector<Expr *> arguments;
+  std::pmr::vector<Expr *> arguments;
+  Get *get_callee;     // the callee if it is a property access, so the call can invoke a method directly
+  Super *super_callee; // the callee if it is a super method access
 };
 
 class Get : public Expr
@@ -73,6 +117,7 @@ public:
 
   Expr *object;
   Token name;
+  PropertyCache cache;
 };
 
 class Grouping : public Expr
@@ -113,6 +158,7 @@ public:
   Expr *object;
   Token name;
   Expr *value;
+  PropertyCache cache;
 };
 
 class Super : public Expr
@@ -123,6 +169,8 @@ public:
 
   Token keyword;
   Token method;
+  Binding binding;      // the binding of "super"
+  Binding this_binding; // the binding of "this" in the method
 };
 
 class This : public Expr
@@ -132,6 +180,7 @@ public:
   Object Accept(Visitor &visitor) override;
 
   Token keyword;
+  Binding binding;
 };
 
 class Unary : public Expr
@@ -151,39 +200,42 @@ public:
   Object Accept(Visitor &visitor) override;
 
   Token name;
+  Binding binding;
 };
 
 class Block : public Stmt
 {
 public:
-  Block(std::vector<Stmt *> statements);
+  Block(std::pmr::vector<Stmt *> statements);
   Object Accept(Visitor &visitor) override;
 
-  std::vector<Stmt *> statements;
+  std::pmr::vector<Stmt *> statements;
+  int locals = 0; // the number of locals the block declares itself, counted by the Resolver
 };
 
 class Function : public Stmt
 {
 public:
   Function() = default;
-  Function(Token name, std::vector<Token> &params, std::vector<Stmt *> &body);
+  Function(Token name, std::pmr::vector<Token> params, std::pmr::vector<Stmt *> body);
 
   Object Accept(Visitor &visitor);
 
   Token name;
-  std::vector<Token> params;
-  std::vector<Stmt *> body;
+  std::pmr::vector<Token> params;
+  std::pmr::vector<Stmt *> body;
+  std::pmr::vector<Capture> upvalues; // the variables of enclosing functions it uses, in the order of its upvalues
 };
 
 class Class : public Stmt
 {
 public:
-  Class(Token name, Variable *superclass, std::vector<Function *> &methods);
+  Class(Token name, Variable *superclass, std::pmr::vector<Function *> methods);
   Object Accept(Visitor &visitor) override;
 
   Token name;
   Variable *superclass;
-  std::vector<Function *> methods;
+  std::pmr::vector<Function *> methods;
 };
 
 class Expression : public Stmt
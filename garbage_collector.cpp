@@ -0,0 +1,124 @@
+/*
+ * garbage_collector.cpp
+ * This file implements the GarbageCollector class defined in garbage_collector.h.
+ *
+ * Collect marks the roots of every registered source, then drains the gray stack, tracing one object at a time so that long chains of
+ * environments or instances cannot overflow the C++ stack. After the weak references have been swept, every object still unmarked is
+ * deleted and the marks of the survivors are cleared for the next cycle. The sizes of the survivors are measured again, so the heap
+ * size after a collection is what is really live.
+ *
+ * After each collection the next one is scheduled when the heap has grown to GROWTH_FACTOR times what survived, but never below the
+ * configured threshold.
+ */
+#include <algorithm>
+#include <chrono>
+#include "garbage_collector.h"
+#include "lox_string.h"
+#include "visit_call_expr.h"
+#include "lox_class.h"
+#include "lox_instance.h"
+#include "lox_upvalue.h"
+
+GarbageCollector &GarbageCollector::Instance()
+{
+    static GarbageCollector collector;
+    return collector;
+}
+GarbageCollector::~GarbageCollector()
+{
+    GcObject *object = objects;
+    while (object != nullptr)
+    {
+        GcObject *next = object->next_object;
+        delete object;
+        object = next;
+    }
+}
+void GarbageCollector::Collect()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (GcRootSource *source : root_sources)
+        source->MarkRoots(*this);
+    while (!gray.empty())
+    {
+        GcObject *object = gray.back();
+        gray.pop_back();
+        object->Trace(*this);
+    }
+    for (GcRootSource *source : root_sources)
+        source->SweepWeakReferences(*this);
+    Sweep();
+
+    next_gc = std::max(bytes_allocated * GROWTH_FACTOR, threshold);
+
+    std::chrono::duration<double, std::milli> pause = std::chrono::steady_clock::now() - start;
+    stats.collections++;
+    stats.total_pause_ms += pause.count();
+    stats.max_pause_ms = std::max(stats.max_pause_ms, pause.count());
+}
+void GarbageCollector::Mark(GcObject *object)
+{
+    if (object == nullptr || object->marked)
+        return;
+    object->marked = true;
+    gray.push_back(object);
+}
+void GarbageCollector::MarkValue(const Object &value)
+{
+    if (value.IsString())
+        Mark(value.AsString());
+    else if (value.IsCallable())
+        Mark(value.AsCallable());
+    else if (value.IsClass())
+        Mark(value.AsClass());
+    else if (value.IsInstance())
+        Mark(value.AsInstance());
+    else if (value.IsUpvalue())
+        Mark(value.AsUpvalue());
+}
+void GarbageCollector::AddRootSource(GcRootSource *source)
+{
+    root_sources.push_back(source);
+}
+void GarbageCollector::RemoveRootSource(GcRootSource *source)
+{
+    root_sources.erase(std::remove(root_sources.begin(), root_sources.end(), source), root_sources.end());
+}
+void GarbageCollector::SetThreshold(size_t bytes)
+{
+    threshold = bytes;
+    next_gc = bytes;
+}
+void GarbageCollector::PrintStats(std::ostream &out) const
+{
+    out << "[gc] collections: " << stats.collections
+        << ", objects freed: " << stats.objects_freed
+        << ", bytes freed: " << stats.bytes_freed
+        << ", heap: " << bytes_allocated << " bytes"
+        << ", total pause: " << stats.total_pause_ms << " ms"
+        << ", max pause: " << stats.max_pause_ms << " ms" << std::endl;
+}
+void GarbageCollector::Sweep()
+{
+    GcObject **link = &objects;
+    while (*link != nullptr)
+    {
+        GcObject *object = *link;
+        if (object->marked)
+        {
+            object->marked = false;
+            size_t size = object->Size();
+            bytes_allocated = bytes_allocated - object->size + size;
+            object->size = size;
+            link = &object->next_object;
+            continue;
+        }
+
+        *link = object->next_object;
+        bytes_allocated -= object->size;
+        stats.bytes_freed += object->size;
+        stats.objects_freed++;
+        delete object;
+    }
+}
@@ -0,0 +1,127 @@
+/*
+ * garbage_collector.h
+ * This file defines the GarbageCollector class, a tracing mark-sweep collector that owns every heap object of the Lox runtime,
+ * and the GcObject and GcRootSource interfaces it works with.
+ *
+ * Every runtime object (environments, functions, classes, instances and the VM's objects) derives from GcObject and is created with
+ * Allocate, which links it into the collector's list of objects. Objects are never deleted by hand.
+ *
+ * Allocation never collects by itself. Once the bytes allocated since the last collection pass the threshold, ShouldCollect returns
+ * true and the interpreter or VM calls Collect at its next safe point, where every value it still needs is reachable from its roots.
+ *
+ * The heap size counts what each object reports with Size: the object itself and the storage it owns, like the characters of a string
+ * or the fields of an instance. An object is charged when it is allocated, its charge is brought up to date when it survives a
+ * collection (its fields or methods may have grown since), and the charge is what is freed with it.
+ *
+ * A GcRootSource (the Interpreter, the VM) registers itself while it is alive. During a collection the collector asks every source to
+ * mark its roots, traces everything reachable from them, lets the sources drop weak references to unmarked objects, and frees the rest.
+ *
+ * The collector keeps statistics: the number of collections, the objects and bytes freed, and the total and longest pause.
+ */
+#ifndef GARBAGE_COLLECTOR_H
+#define GARBAGE_COLLECTOR_H
+
+#include <cstddef>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "object.h"
+
+class GarbageCollector;
+
+class GcObject
+{
+public:
+    virtual ~GcObject() {}
+    // marks every object this object references
+    virtual void Trace(GarbageCollector &gc) = 0;
+    // returns the bytes the object holds: itself and the storage it owns
+    virtual size_t Size() const = 0;
+
+private:
+    friend class GarbageCollector;
+
+    bool marked = false;
+    size_t size = 0;                // the bytes accounted to this object, as of its allocation or the last collection
+    GcObject *next_object = nullptr; // the next object in the collector's list
+};
+
+class GcRootSource
+{
+public:
+    virtual ~GcRootSource() {}
+    // marks every object the source can still reach directly
+    virtual void MarkRoots(GarbageCollector &gc) = 0;
+    // drops weak references to objects that were not marked, just before they are freed
+    virtual void SweepWeakReferences(GarbageCollector &) {}
+};
+
+// returns the bytes an unordered_map owns: its bucket array and one node per element
+template <typename Key, typename Value>
+size_t MapSize(const std::unordered_map<Key, Value> &map)
+{
+    return map.bucket_count() * sizeof(void *) + map.size() * (sizeof(std::pair<const Key, Value>) + 2 * sizeof(void *));
+}
+
+class GarbageCollector
+{
+public:
+    struct Stats
+    {
+        size_t collections = 0;
+        size_t objects_freed = 0;
+        size_t bytes_freed = 0;
+        double total_pause_ms = 0;
+        double max_pause_ms = 0;
+    };
+
+    // the collector shared by every interpreter and VM in the process
+    static GarbageCollector &Instance();
+    ~GarbageCollector();
+
+    template <typename T, typename... Args>
+    T *Allocate(Args &&...args)
+    {
+        T *object = new T(std::forward<Args>(args)...);
+        object->size = object->Size();
+        object->next_object = objects;
+        objects = object;
+        bytes_allocated += object->size;
+        return object;
+    }
+    // whether enough has been allocated that the next safe point should collect
+    bool ShouldCollect() const { return bytes_allocated > next_gc; }
+    void Collect();
+
+    void Mark(GcObject *object);
+    void MarkValue(const Object &value);
+    bool IsMarked(GcObject *object) const { return object->marked; }
+
+    void AddRootSource(GcRootSource *source);
+    void RemoveRootSource(GcRootSource *source);
+
+    // sets the heap size that triggers the first collection, and the minimum for every later one
+    void SetThreshold(size_t bytes);
+    const Stats &GetStats() const { return stats; }
+    size_t BytesAllocated() const { return bytes_allocated; }
+    void PrintStats(std::ostream &out) const;
+
+private:
+    static const size_t DEFAULT_THRESHOLD = 1024 * 1024;
+    static const int GROWTH_FACTOR = 2;
+
+    GarbageCollector() = default;
+
+    GcObject *objects = nullptr;
+    std::vector<GcObject *> gray; // marked objects whose references have not been traced yet
+    std::vector<GcRootSource *> root_sources;
+    size_t bytes_allocated = 0;
+    size_t threshold = DEFAULT_THRESHOLD;
+    size_t next_gc = DEFAULT_THRESHOLD;
+    Stats stats;
+
+    void Sweep();
+};
+
+#endif // GARBAGE_COLLECTOR_H
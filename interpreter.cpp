@@ -3,17 +3,26 @@
  * This file implements the Interpreter class defined in interpreter.h.
  * The Interpreter class is the core of the Lox language. It interprets and executes Lox code.
  *
- * The constructor initializes the interpreter with a new global environment and a new locals map.
+ * The constructor creates the global environment and registers the interpreter as a root source of the garbage collector.
  *
- * The destructor deletes the environments and the locals map.
+ * The destructor unregisters it; the global environment is freed by the collector.
  *
  * The Interpret method is the entry point of the interpreter. It takes a list of statements and interprets them. If an error occurs during interpretation, it is caught and reported.
+ * It first gives the global table a slot for every symbol, so that no global read has to check the table's size.
  *
- * The ExecuteBlock method executes a block of statements in a given environment. It creates a new environment for the block, executes the statements in this environment, and then restores the previous environment.
+ * The ExecuteBlock method executes a list of statements in the current frame.
+ * It stops at the first statement that does not complete normally and returns that statement's completion.
  *
- * The Resolve method resolves a variable and stores its depth in the locals map.
+ * PushFrame saves the caller's frame and starts the callee's where its arguments are on the value stack; for a method, "this" replaces
+ * the callee in the slot below them. PopFrame restores the caller's frame. A block statement pops the slots of its locals when it ends,
+ * so a block allocates nothing, and a loop body reuses the same slots on every iteration; a block the Resolver found declares nothing
+ * just runs its statements. A local is only moved to the heap when a closure captures it, once for each time its declaration runs.
  *
  * The Visit... methods are used to visit different types of expressions and statements. They evaluate expressions, execute statements, and handle control flow.
+ * A call whose callee is a property access or a super method access invokes the method on the receiver directly, so calling a method
+ * allocates nothing. Reading a method without calling it still creates a bound method.
+ *
+ * The FindSuperMethod method finds the method a super expression names, starting at the superclass, and the instance to call it on.
  *
  * The CheckNumberOperand and CheckNumberOperands methods check if the operand(s) of an operation are numbers. If not, they throw a RuntimeError.
  *
@@ -23,11 +32,26 @@
  *
  * The Evaluate method evaluates an expression and returns its value.
  *
- * The Execute method executes a statement. If a return statement is encountered, it throws a Return exception.
+ * The Execute method executes a statement, running a pending garbage collection first, and returns its completion. A return statement stores
+ * its value in return_value and sets the completion to RETURN; if, while and block statements stop and pass it on, and the function call takes
+ * the value with TakeReturnValue.
+ *
+ * The LookUpVariable and AssignVariable methods reach a local in the slot the Resolver assigned to it, through the upvalue that took its
+ * place if a closure captured it, an upvalue of the running closure by its index, or a global by the symbol of its name. If a global is undefined, they throw a RuntimeError.
  *
- * The LookUpVariable method looks up a variable in the environment. If the variable is not found, it throws a RuntimeError.
+ * The DefineVariable method defines a declaration: at the top level outside any block, globals are stored in their slot; locals are pushed
+ * onto the value stack, which puts them in the next free slot of the frame, the slot the Resolver assigned because both number the
+ * declarations of a function in the order they appear.
+ *
+ * The NewFunction method creates a LoxFunction with the upvalues its declaration lists: CaptureLocal hoists a local of the current
+ * frame into an upvalue, which takes the local's place in its slot so that the frame and every closure share it, and an upvalue of
+ * the running closure is shared as it is. A local function or class is defined before its methods are created, so they can capture it.
  *
  * The Stringify method converts an object to a string.
+ *
+ * The MarkRoots method marks the global environment, the functions of the running frames, and the value stack.
+ * Binary, set and call expressions push their already evaluated operands on the value stack, because evaluating the remaining operands
+ * may call a function whose statements are safe points.
  */
 #include <typeinfo>
 #include "interpreter.h"
@@ -35,21 +59,24 @@
 #include "parser.h"
 #include "visit_call_expr.h"
 #include "lox_function.h"
-#include <variant>
-#include "return_method.h"
 #include "lox_class.h"
 #include "lox_instance.h"
+#include "lox_upvalue.h"
+#include "lox_string.h"
+#include "string_table.h"
 
+Interpreter::Interpreter()
+{
+    globals = GarbageCollector::Instance().Allocate<Environment>();
+    GarbageCollector::Instance().AddRootSource(this);
+}
 Interpreter::~Interpreter()
 {
-    // 如果globals和environment指向不同 那么删除
-    if (globals != environment)
-        delete environment;
-
-    delete globals;
+    GarbageCollector::Instance().RemoveRootSource(this);
 }
-void Interpreter::Interpret(std::vector<Stmt *> statements)
+void Interpreter::Interpret(const std::pmr::vector<Stmt *> &statements)
 {
+    globals->Resize(SymbolTable::Instance().Count()); // a slot for every name the program uses
     try
     {
         for (const auto &statement : statements)
@@ -57,46 +84,79 @@ void Interpreter::Interpret(std::vector<Stmt *> statements)
     }
     catch (const RuntimeError &error)
     {
+        frame = Frame{0, nullptr, 0};
+        saved_frames.clear();
+        stack.clear();
+        completion = Completion::NORMAL;
         Error::ProcessRuntimeError(error);
     }
 }
-void Interpreter::ExecuteBlock(std::vector<Stmt *> statements, Environment *environment)
+Interpreter::Completion Interpreter::ExecuteBlock(const std::pmr::vector<Stmt *> &statements)
 {
-    Environment *previous = this->environment;
-    try
-    {
-        this->environment = environment; // 切换环境
-        for (auto statement : statements)
-        {
-            Execute(statement);
-        }
-    }
-    catch (const Return_method &returnValue)
+    Completion result = Completion::NORMAL;
+    for (auto statement : statements)
     {
-        this->environment = previous;
-        throw returnValue;
-        return;
+        result = Execute(statement);
+        if (result != Completion::NORMAL)
+            break;
     }
-    this->environment = previous; // 抛出return后这里不会执行
+    return result;
 }
-void Interpreter::Resolve(Expr *expr, int depth)
+void Interpreter::PushFrame(LoxFunction *function, LoxInstance *receiver, Arguments arguments)
 {
-    locals[expr] = depth;
+    saved_frames.push_back(frame);
+    size_t base = arguments.begin() - stack.data();
+    if (receiver != nullptr)
+        stack[--base] = receiver; // "this"
+    frame = Frame{base, function, 0};
+}
+void Interpreter::PopFrame()
+{
+    frame = saved_frames.back();
+    saved_frames.pop_back();
+}
+Object Interpreter::TakeReturnValue()
+{
+    completion = Completion::NORMAL;
+    Object value = return_value;
+    return_value = nullptr;
+    return value;
+}
+void Interpreter::PushRoot(Object value)
+{
+    stack.push_back(value);
+}
+void Interpreter::PopRoots(size_t count)
+{
+    stack.resize(stack.size() - count);
+}
+void Interpreter::MarkRoots(GarbageCollector &gc)
+{
+    gc.Mark(globals);
+    gc.Mark(frame.function);
+    for (const Frame &saved : saved_frames)
+        gc.Mark(saved.function);
+    for (const Object &value : stack)
+        gc.MarkValue(value);
+    gc.MarkValue(return_value);
 }
-
 Object Interpreter::VisitSuperExpr(Super &Expr)
 {
-    int distance = locals[&Expr];
-    LoxClass *superclass = std::get<LoxClass *>(environment->GetAt(distance, "super"));
-    LoxInstance *object = std::get<LoxInstance *>(environment->GetAt(distance - 1, "this"));
-    LoxFunction *method = superclass->FindMethod(Expr.method.lexeme);
+    LoxInstance *object = nullptr;
+    LoxFunction *method = FindSuperMethod(Expr, object);
+    return method->Bind(object);
+}
+LoxFunction *Interpreter::FindSuperMethod(Super &expr, LoxInstance *&receiver)
+{
+    LoxClass *superclass = LookUpVariable(expr.keyword, expr.binding).AsClass();
+    receiver = LookUpVariable(expr.keyword, expr.this_binding).AsInstance();
+    LoxFunction *method = superclass->FindMethod(expr.method.symbol);
     if (method == nullptr)
     {
-        throw RuntimeError(Expr.method,
-                           "Undefined property '" + Expr.method.lexeme + "'.");
+        throw RuntimeError(expr.method,
+                           "Undefined property '" + std::string(expr.method.Lexeme()) + "'.");
     }
-
-    return method->Bind(object);
+    return method;
 }
 Object Interpreter::VisitLiteralExpr(Literal &expr)
 {
@@ -122,13 +182,9 @@ Object Interpreter::VisitLogicalExpr(Logical &expr)
 Object Interpreter::VisitGetExpr(Get &expr)
 {
     Object object = Evaluate(expr.object);
-    if (std::holds_alternative<LoxInstance *>(object))
-    {
-        return ((std::get<LoxInstance *>(object))->Get(expr.name));
-    }
-    if (std::holds_alternative<std::nullptr_t>(object))
+    if (object.IsInstance())
     {
-        std::cout << "err" << std::endl;
+        return ((object.AsInstance())->Get(expr.name, expr.cache));
     }
     throw RuntimeError(expr.name,
                        "Only instances have properties.");
@@ -137,19 +193,21 @@ Object Interpreter::VisitSetExpr(Set &expr)
 {
 
     Object object = Evaluate(expr.object); // right
-    if (!(std::holds_alternative<LoxInstance *>(object)))
+    if (!(object.IsInstance()))
     {
         throw RuntimeError(expr.name,
                            "Only instances have fields.");
     }
 
+    PushRoot(object);
     Object value = Evaluate(expr.value);
-    (std::get<LoxInstance *>(object))->Set(expr.name, value);
+    PopRoots(1);
+    (object.AsInstance())->Set(expr.name, value, expr.cache);
     return value;
 }
 Object Interpreter::VisitThisExpr(This &expr)
 {
-    return LookUpVariable(expr.keyword, &expr);
+    return LookUpVariable(expr.keyword, expr.binding);
 }
 Object Interpreter::VisitUnaryExpr(Unary &expr)
 {
@@ -161,7 +219,7 @@ Object Interpreter::VisitUnaryExpr(Unary &expr)
         return !IsTruthy(right);
     case MINUS:
         CheckNumberOperand(expr.op, right);
-        return -std::get<double>(right);
+        return -right.AsNumber();
     default:
         break;
     }
@@ -171,7 +229,7 @@ Object Interpreter::VisitUnaryExpr(Unary &expr)
 }
 Object Interpreter::VisitVariableExpr(Variable &expr)
 {
-    return LookUpVariable(expr.name, &expr);
+    return LookUpVariable(expr.name, expr.binding);
 }
 
 Object Interpreter::VisitGroupingExpr(Grouping &expr)
@@ -182,43 +240,45 @@ Object Interpreter::VisitGroupingExpr(Grouping &expr)
 Object Interpreter::VisitBinaryExpr(Binary &expr)
 {
     Object left = Evaluate(expr.left);
+    PushRoot(left);
     Object right = Evaluate(expr.right);
+    PopRoots(1);
 
     switch (expr.op.type)
     {
     case GREATER:
         CheckNumberOperands(expr.op, left, right);
-        return std::get<double>(left) > std::get<double>(right);
+        return left.AsNumber() > right.AsNumber();
     case GREATER_EQUAL:
         CheckNumberOperands(expr.op, left, right);
-        return std::get<double>(left) >= std::get<double>(right);
+        return left.AsNumber() >= right.AsNumber();
     case LESS:
         CheckNumberOperands(expr.op, left, right);
-        return std::get<double>(left) < std::get<double>(right);
+        return left.AsNumber() < right.AsNumber();
     case LESS_EQUAL:
         CheckNumberOperands(expr.op, left, right);
-        return std::get<double>(left) <= std::get<double>(right);
+        return left.AsNumber() <= right.AsNumber();
     case MINUS:
         CheckNumberOperands(expr.op, left, right);
-        return std::get<double>(left) - std::get<double>(right);
+        return left.AsNumber() - right.AsNumber();
     case PLUS:
-        if (std::holds_alternative<double>(left) && std::holds_alternative<double>(right))
+        if (left.IsNumber() && right.IsNumber())
         {
-            return std::get<double>(left) + std::get<double>(right);
+            return left.AsNumber() + right.AsNumber();
         }
 
-        if (std::holds_alternative<std::string>(left) && std::holds_alternative<std::string>(right))
+        if (left.IsString() && right.IsString())
         {
-            return std::get<std::string>(left) + std::get<std::string>(right);
+            return StringTable::Instance().Intern(left.AsString()->chars + right.AsString()->chars);
         }
         throw RuntimeError(expr.op, "Operands must be two numbers or two strings.");
         break;
     case SLASH:
         CheckNumberOperands(expr.op, left, right);
-        return std::get<double>(left) / std::get<double>(right);
+        return left.AsNumber() / right.AsNumber();
     case STAR:
         CheckNumberOperands(expr.op, left, right);
-        return std::get<double>(left) * std::get<double>(right);
+        return left.AsNumber() * right.AsNumber();
     case BANG_EQUAL:
         return !IsEqual(left, right);
     case EQUAL_EQUAL:
@@ -232,127 +292,169 @@ Object Interpreter::VisitBinaryExpr(Binary &expr)
 }
 Object Interpreter::VisitCallExpr(Call &expr)
 {
-    Object callee = Evaluate(expr.callee); // bool
-
-    std::vector<Object> arguments_;
-    for (Expr *argument : expr.arguments)
+    // instance.name(...) and super.name(...) invoke a method on the receiver without creating a bound method
+    Object callee = nullptr;
+    LoxInstance *receiver = nullptr;
+    LoxFunction *method = nullptr;
+    if (expr.get_callee != nullptr)
     {
-        arguments_.push_back(Evaluate(argument));
+        Object object = Evaluate(expr.get_callee->object);
+        if (!object.IsInstance())
+            throw RuntimeError(expr.get_callee->name, "Only instances have properties.");
+        receiver = object.AsInstance();
+        method = receiver->FindProperty(expr.get_callee->name, expr.get_callee->cache, callee);
     }
-    if ((std::holds_alternative<LoxClass *>(callee)))
+    else if (expr.super_callee != nullptr)
     {
-        LoxCallable *temp = static_cast<LoxCallable *>(std::get<LoxClass *>(callee));
-        callee = temp;
-        if (!(std::holds_alternative<LoxCallable *>(callee)))
-        {
-            throw RuntimeError(expr.paren, "Can only call functions and classes.");
-        }
-        LoxCallable *function = std::get<LoxCallable *>(callee);
-        if (static_cast<int>(arguments_.size()) != function->Arity())
-        {
-            throw RuntimeError(expr.paren, "Expected " + std::to_string(function->Arity()) + " arguments but got " + std::to_string(arguments_.size()) + ".");
-        }
-        Object ret = function->Call(this, arguments_);
-        // delete function;
-        return ret;
+        method = FindSuperMethod(*expr.super_callee, receiver);
     }
     else
     {
-        if (!(std::holds_alternative<LoxCallable *>(callee)))
-        {
+        callee = Evaluate(expr.callee);
+    }
+
+    // the callee (or the method's receiver) and the arguments are evaluated onto the value stack, where they stay until the call returns;
+    // they are the start of the callee's frame, and the call pops the frame with them
+    size_t top = stack.size();
+    PushRoot(method != nullptr ? Object(receiver) : callee);
+    for (Expr *argument : expr.arguments)
+        PushRoot(Evaluate(argument));
+    // the arguments' place is only known once they are all evaluated, as evaluating them may grow the stack
+    Arguments arguments{stack.data() + stack.size() - expr.arguments.size(), expr.arguments.size()};
+
+    LoxCallable *function = method;
+    if (function == nullptr)
+    {
+        if (callee.IsClass())
+            function = callee.AsClass();
+        else if (callee.IsCallable())
+            function = callee.AsCallable();
+        else
             throw RuntimeError(expr.paren, "Can only call functions and classes.");
-        }
-        LoxCallable *function = std::get<LoxCallable *>(callee);
-        if (static_cast<int>(arguments_.size()) != function->Arity()) // Cast the size of arguments_ to int
-        {
-            throw RuntimeError(expr.paren, "Expected " + std::to_string(function->Arity()) + " arguments but got " + std::to_string(arguments_.size()) + ".");
-        }
-        LoxFunction *loxFunction = dynamic_cast<LoxFunction *>(function);
-        Object ret = loxFunction->Call(this, arguments_);
-        // delete function;
-        return ret;
     }
+    if (static_cast<int>(arguments.size()) != function->Arity())
+    {
+        throw RuntimeError(expr.paren, "Expected " + std::to_string(function->Arity()) + " arguments but got " + std::to_string(arguments.size()) + ".");
+    }
+
+    Object ret = method != nullptr ? method->Invoke(this, receiver, arguments) : function->Call(this, arguments);
+    stack.resize(top);
+    return ret;
 }
 void Interpreter::CheckNumberOperand(Token op, Object operand) // 检查操作数是否为数字
 {
-    if (std::holds_alternative<double>(operand))
+    if (operand.IsNumber())
         return;
     throw RuntimeError(op, "Operand must be a number.");
 }
 void Interpreter::CheckNumberOperands(Token op, Object left, Object right) // 检查操作数是否为数字
 {
-    if (std::holds_alternative<double>(left) && std::holds_alternative<double>(right))
+    if (left.IsNumber() && right.IsNumber())
         return;
 
     throw RuntimeError(op, "Operands must be numbers.");
 }
 bool Interpreter::IsTruthy(Object object)
 {
-    if (std::holds_alternative<std::nullptr_t>(object))
+    if (object.IsNil())
         return false;
-    if (std::holds_alternative<bool>(object))
-        return std::get<bool>(object);
+    if (object.IsBool())
+        return object.AsBool();
     return true;
 }
 bool Interpreter::IsEqual(Object a, Object b)
 {
-    if (std::holds_alternative<std::nullptr_t>(a) && std::holds_alternative<std::nullptr_t>(b))
-        return true;
-    if (std::holds_alternative<std::nullptr_t>(a))
-        return false;
-
-    if (a.index() != b.index())
-    {
-        return false;
-    }
-
-    if (std::holds_alternative<double>(a))
-    {
-        return std::get<double>(a) == std::get<double>(b);
-    }
-    else if (std::holds_alternative<std::string>(a))
-    {
-        return std::get<std::string>(a) == std::get<std::string>(b);
-    }
-    else if (std::holds_alternative<std::nullptr_t>(a))
-    {
-        return true;
-    }
-    else if (std::holds_alternative<bool>(a))
-    {
-        return std::get<bool>(a) == std::get<bool>(b);
-    }
-
-    return false;
+    // values of different types are never equal; callables, classes and instances compare by identity
+    return a == b;
 }
 Object Interpreter::Evaluate(Expr *expr)
 {
     return expr->Accept(*this);
 }
-void Interpreter::Execute(Stmt *stmt)
+Interpreter::Completion Interpreter::Execute(Stmt *stmt)
 {
+    GarbageCollector &gc = GarbageCollector::Instance();
+    if (gc.ShouldCollect())
+        gc.Collect();
+    completion = Completion::NORMAL;
     stmt->Accept(*this);
+    return completion;
 }
-Object Interpreter::LookUpVariable(Token name, Expr *expr)
+Object Interpreter::LookUpVariable(const Token &name, const Binding &binding)
 {
-    auto ret = locals.find(expr);
-    if (ret != locals.end())
+    switch (binding.kind)
     {
-        int distance = ret->second;
-        return environment->GetAt(distance, name.lexeme); //
-    }
-    else
+    case Binding::LOCAL:
     {
+        Object value = stack[frame.base + binding.index];
+        return value.IsUpvalue() ? value.AsUpvalue()->value : value;
+    }
+    case Binding::UPVALUE:
+        return frame.function->GetUpvalue(binding.index)->value;
+    default:
         return globals->Get(name);
     }
 }
+void Interpreter::AssignVariable(const Token &name, const Binding &binding, Object value)
+{
+    switch (binding.kind)
+    {
+    case Binding::LOCAL:
+    {
+        Object &local = stack[frame.base + binding.index];
+        if (local.IsUpvalue())
+            local.AsUpvalue()->value = value;
+        else
+            local = value;
+        break;
+    }
+    case Binding::UPVALUE:
+        frame.function->GetUpvalue(binding.index)->value = value;
+        break;
+    default:
+        globals->Assign(name, value);
+        break;
+    }
+}
+int Interpreter::DefineVariable(const Token &name, Object value)
+{
+    if (frame.function == nullptr && frame.blocks == 0)
+    {
+        globals->Define(name.symbol, value);
+        return -1;
+    }
+    stack.push_back(value);
+    return static_cast<int>(stack.size() - frame.base) - 1;
+}
+LoxFunction *Interpreter::NewFunction(const Function *declaration, bool is_initializer)
+{
+    std::vector<LoxUpvalue *> upvalues;
+    upvalues.reserve(declaration->upvalues.size());
+    for (const Capture &capture : declaration->upvalues)
+        upvalues.push_back(capture.is_local ? CaptureLocal(capture.index) : frame.function->GetUpvalue(capture.index));
+    return GarbageCollector::Instance().Allocate<LoxFunction>(declaration, std::move(upvalues), is_initializer);
+}
+LoxUpvalue *Interpreter::CaptureLocal(int slot)
+{
+    Object &local = stack[frame.base + slot];
+    if (!local.IsUpvalue())
+        local = GarbageCollector::Instance().Allocate<LoxUpvalue>(local);
+    return local.AsUpvalue();
+}
 Object Interpreter::VisitBlockStmt(Block &stmt)
 {
-    Environment *new_environment = new Environment(environment);
-
-    ExecuteBlock(stmt.statements, new_environment);
+    // a block without declarations has no scope of its own to open and close, like the body of most loops
+    if (stmt.locals == 0)
+    {
+        ExecuteBlock(stmt.statements);
+        return nullptr;
+    }
 
-    delete new_environment;
+    size_t top = stack.size();
+    frame.blocks++;
+    ExecuteBlock(stmt.statements);
+    frame.blocks--;
+    stack.resize(top); // the block's locals
 
     return nullptr;
 }
@@ -363,34 +465,34 @@ Object Interpreter::VisitClassStmt(Class &stmt)
     {
         superclass = Evaluate(stmt.superclass);
 
-        if (!(std::holds_alternative<LoxClass *>(superclass)))
+        if (!(superclass.IsClass()))
             throw RuntimeError(stmt.superclass->name, "Superclass must be a class.");
     }
-    environment->Define(stmt.name.lexeme, nullptr);
+    int slot = DefineVariable(stmt.name, nullptr);
     if (stmt.superclass != nullptr)
-    {
-        environment = new Environment(environment); // 原来的环境保存在environment->enclosing中
-        environment->Define("super", superclass);   // 现在的environment是interpreter中的environment，会在interpreter的析构函数中被delete
-    }
-    std::unordered_map<std::string, LoxFunction *> methods;
+        stack.push_back(superclass); // "super", the local of a scope around the methods
+    std::unordered_map<Symbol, LoxFunction *> methods;
     for (Function *method : stmt.methods)
     {
-        LoxFunction *function = new LoxFunction(*method, environment, (method->name.lexeme.compare("init") == 0)); // function在LoxClass的析构函数中会被delete
-        methods[method->name.lexeme] = function;
+        LoxFunction *function = NewFunction(method, method->name.symbol == SymbolTable::INIT);
+        methods[method->name.symbol] = function;
     }
 
     LoxClass *klass = nullptr;
-    if (std::holds_alternative<std::nullptr_t>(superclass)) // superclass == null
-    {                                                       // klass在environment的析构函数中会被delete
-        klass = new LoxClass(stmt.name.lexeme, std::get<std::nullptr_t>(superclass), methods);
+    if (superclass.IsNil()) // superclass == null
+    {
+        klass = GarbageCollector::Instance().Allocate<LoxClass>(std::string(stmt.name.Lexeme()), nullptr, methods);
     }
     else
     {
-        klass = new LoxClass(stmt.name.lexeme, std::get<LoxClass *>(superclass), methods);
-        environment = environment->Get_enclosing(); // 退出环境
+        klass = GarbageCollector::Instance().Allocate<LoxClass>(std::string(stmt.name.Lexeme()), superclass.AsClass(), methods);
+        stack.pop_back(); // 退出 "super" 的作用域
     }
 
-    environment->Assign(stmt.name, klass); // 将类名和类的映射关系存入环境中
+    if (slot < 0) // 将类名和类的映射关系存入环境中
+        globals->Assign(stmt.name, klass);
+    else
+        AssignVariable(stmt.name, Binding{Binding::LOCAL, slot}, klass);
 
     return nullptr;
 }
@@ -401,10 +503,13 @@ Object Interpreter::VisitExpressionStmt(Expression &stmt)
 }
 Object Interpreter::VisitFunctionStmt(Function &stmt)
 {
-    LoxFunction *function = new LoxFunction(stmt, environment, false); // function在environment的析构函数中会被delete
+    int slot = DefineVariable(stmt.name, nullptr);
+    LoxCallable *function = NewFunction(&stmt, false);
 
-    LoxCallable *callable = function;
-    environment->Define(stmt.name.lexeme, callable);
+    if (slot < 0)
+        globals->Define(stmt.name.symbol, function);
+    else
+        AssignVariable(stmt.name, Binding{Binding::LOCAL, slot}, function);
     return nullptr;
 }
 Object Interpreter::VisitIfStmt(If &stmt)
@@ -433,8 +538,8 @@ Object Interpreter::VisitReturnStmt(Return &stmt)
         value = Evaluate(stmt.value);
     }
 
-    throw Return_method(value);
-
+    return_value = value;
+    completion = Completion::RETURN;
     return nullptr;
 }
 Object Interpreter::VisitVarStmt(Var &stmt)
@@ -445,41 +550,35 @@ Object Interpreter::VisitVarStmt(Var &stmt)
         value = Evaluate(stmt.initializer);
     }
 
-    environment->Define(stmt.name.lexeme, value);
+    DefineVariable(stmt.name, value);
     return nullptr;
 }
 Object Interpreter::VisitWhileStmt(While &stmt)
 {
     while (IsTruthy(Evaluate(stmt.condition)))
-        Execute(stmt.body);
+    {
+        if (Execute(stmt.body) != Completion::NORMAL)
+            break;
+    }
 
     return nullptr;
 }
 Object Interpreter::VisitAssignExpr(Assign &expr)
 {
     Object value = Evaluate(expr.value);
-    auto ret = locals.find(&expr);
-    if (ret != locals.end())
-    {
-        int distance = ret->second;
-        environment->AssignAt(distance, expr.name, value);
-    }
-    else
-    {
-        globals->Assign(expr.name, value);
-    }
+    AssignVariable(expr.name, expr.binding, value);
 
     return value;
 }
 
 std::string Interpreter::Stringify(Object object)
 {
-    if (std::holds_alternative<std::nullptr_t>(object))
+    if (object.IsNil())
         return "nil";
 
-    else if (std::holds_alternative<double>(object))
+    else if (object.IsNumber())
     {
-        std::string text = std::to_string(std::get<double>(object));
+        std::string text = std::to_string(object.AsNumber());
 
         size_t dotPosition = text.find('.');
         if (dotPosition != std::string::npos)
@@ -498,24 +597,24 @@ std::string Interpreter::Stringify(Object object)
         }
         return text;
     }
-    else if (std::holds_alternative<bool>(object))
+    else if (object.IsBool())
     {
-        return std::get<bool>(object) ? "true" : "false";
+        return object.AsBool() ? "true" : "false";
     }
-    else if (std::holds_alternative<LoxCallable *>(object))
+    else if (object.IsCallable())
     {
         return "function";
     }
-    else if (std::holds_alternative<LoxClass *>(object))
+    else if (object.IsClass())
     {
-        LoxClass *klass = std::get<LoxClass *>(object);
+        LoxClass *klass = object.AsClass();
         return klass->ToString();
     }
-    else if (std::holds_alternative<LoxInstance *>(object))
+    else if (object.IsInstance())
     {
-        LoxInstance *klass = std::get<LoxInstance *>(object);
+        LoxInstance *klass = object.AsInstance();
         return klass->ToString();
     }
     else
-        return std::get<std::string>(object);
+        return object.AsString()->chars;
 }
@@ -9,9 +9,11 @@
  *
  * The Interpret method is the entry point of the interpreter. It takes a list of statements and interprets them.
  *
- * The ExecuteBlock method executes a block of statements in a given environment.
+ * The ExecuteBlock method executes a list of statements in the current frame. PushFrame and PopFrame start and end the frame of a call.
  *
- * The Resolve method resolves a variable and stores its depth in the locals map.
+ * Statements complete with a Completion status instead of throwing. A return statement stores its value and completes with RETURN;
+ * Execute and ExecuteBlock hand that status up to the enclosing statements, which stop at once, until the function call that started
+ * them takes the return value with TakeReturnValue. Exceptions are only used for RuntimeErrors.
  *
  * The Visit... methods are used to visit different types of expressions and statements. They override the methods defined in the Visitor class.
  *
@@ -23,11 +25,25 @@
  *
  * The Evaluate method evaluates an expression and returns its value.
  *
- * The Execute method executes a statement.
+ * The Execute method executes a statement and returns how it completed.
  *
- * The LookUpVariable method looks up a variable in the environment.
+ * The LookUpVariable and AssignVariable methods read and assign a variable where the Resolver bound it: in a slot of the current
+ * frame, in an upvalue of the running closure, or in the slot of the global table indexed by the symbol of its name.
+ *
+ * The DefineVariable method defines a declared name: by name at the top level, in the next local slot anywhere else.
+ *
+ * The NewFunction method creates a closure, capturing the variables its declaration lists from the current frame and closure.
  *
  * The Stringify method converts an object to a string.
+ *
+ * Locals live on the value stack. Each call runs in a Frame: its slots start with "this" for a method and the parameters, where
+ * the caller evaluated the arguments, and go on with the locals of the body and of its blocks in the order they are declared, at the
+ * slots the Resolver numbered them with. A block pops its locals when it ends. The top level is a frame too, whose locals are those of
+ * its blocks. A local that a closure captured is replaced in its slot by an upvalue, and is read and assigned through it.
+ *
+ * The Interpreter is a root source of the garbage collector. Its roots are the global environment, the functions of the running
+ * frames, and the value stack: the locals, and the values that are still needed while a subexpression is evaluated (PushRoot / PopRoots).
+ * Every Execute is a safe point where a pending collection runs.
  */
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
@@ -40,23 +56,57 @@
 #include "lox_function.h"
 #include "error.h"
 #include "lox_class.h"
+#include "garbage_collector.h"
 
-class Interpreter : public Visitor // 后面换成visitor
+class Interpreter : public Visitor, public GcRootSource // 后面换成visitor
 {
 public:
-    Interpreter() = default;
+    // how a statement finished: normally, or by a return statement that unwinds to the function call
+    enum class Completion
+    {
+        NORMAL,
+        RETURN
+    };
+
+    Interpreter();
+    Interpreter(const Interpreter &) = delete;
     ~Interpreter();
     // entry point of the interpreter
-    void Interpret(std::vector<Stmt *> statements);
-    // executes a block of statements in a given environment
-    void ExecuteBlock(std::vector<Stmt *> statements, Environment *environment);
-    // resolves a variable and stores its depth in the locals map
-    void Resolve(Expr *expr, int depth);
+    void Interpret(const std::pmr::vector<Stmt *> &statements);
+    // executes a list of statements in the current frame
+    Completion ExecuteBlock(const std::pmr::vector<Stmt *> &statements);
+    // starts the frame of a call to a function: its slots start with the receiver, if any, and the arguments, which must be the top of the value stack
+    void PushFrame(LoxFunction *function, LoxInstance *receiver, Arguments arguments);
+    // returns to the frame of the caller, which pops the slots of the call with its arguments
+    void PopFrame();
+    // returns the value of the return statement that completed a function body, and resets the completion
+    Object TakeReturnValue();
+    // convert an object to a string
+    static std::string Stringify(Object object);
+    // check if an object is truthy, and if two objects are equal, by the rules of the Lox language
+    static bool IsTruthy(Object object);
+    static bool IsEqual(Object a, Object b);
+    // keeps a value alive until it is popped
+    void PushRoot(Object value);
+    void PopRoots(size_t count);
+    // marks the globals, the running functions and the values the interpreter is using
+    void MarkRoots(GarbageCollector &gc) override;
 
 private:
-    Environment *globals = new Environment();
-    Environment *environment = globals;
-    std::unordered_map<Expr *, int> locals;
+    // the frame of a call, or of the top level
+    struct Frame
+    {
+        size_t base;           // the index of slot 0 on the value stack
+        LoxFunction *function; // the function running in the frame, whose upvalues it uses; nullptr for the top level
+        int blocks;            // the number of blocks entered in the frame; declarations outside any block of the top level are global
+    };
+
+    Environment *globals;
+    Frame frame{0, nullptr, 0};                 // the frame of the running function
+    std::vector<Frame> saved_frames;            // the frames of the calls that are waiting for it
+    std::vector<Object> stack;                  // the slots of the frames, and values held while other expressions are evaluated
+    Completion completion = Completion::NORMAL; // how the statement being executed completed
+    Object return_value;                        // the value of the return statement being unwound
     // visitor methods
     Object VisitSuperExpr(Super &Expr) override;
     Object VisitLiteralExpr(Literal &expr) override;
@@ -69,18 +119,24 @@ private:
     Object VisitGroupingExpr(Grouping &expr) override;
     Object VisitBinaryExpr(Binary &expr) override;
     Object VisitCallExpr(Call &expr);
+    // finds the method a super expression refers to, and the instance it is called on
+    LoxFunction *FindSuperMethod(Super &expr, LoxInstance *&receiver);
     // check if the operand(s) of an operation are numbers
     void CheckNumberOperand(Token op, Object operand);
     void CheckNumberOperands(Token op, Object left, Object right);
-
-    bool IsTruthy(Object object);
-    bool IsEqual(Object a, Object b);
     // evaluate an expression and return its value
     Object Evaluate(Expr *expr);
     // execute a statement
-    void Execute(Stmt *stmt);
-    // look up a variable in the environment
-    Object LookUpVariable(Token name, Expr *expr);
+    Completion Execute(Stmt *stmt);
+    // read and assign a variable where the Resolver bound it
+    Object LookUpVariable(const Token &name, const Binding &binding);
+    void AssignVariable(const Token &name, const Binding &binding, Object value);
+    // define a declared variable, as a global or in the next slot of the frame, and return its slot, or -1 for a global
+    int DefineVariable(const Token &name, Object value);
+    // create a closure of a function declared in the current frame, capturing the variables it uses
+    LoxFunction *NewFunction(const Function *declaration, bool is_initializer);
+    // hoist a local of the current frame into an upvalue, unless a closure already captured it
+    LoxUpvalue *CaptureLocal(int slot);
     // visit methods
     Object VisitBlockStmt(Block &stmt) override;
     Object VisitClassStmt(Class &stmt) override;
@@ -92,8 +148,6 @@ private:
     Object VisitVarStmt(Var &stmt) override;
     Object VisitWhileStmt(While &stmt) override;
     Object VisitAssignExpr(Assign &expr);
-    // convert an object to a string
-    std::string Stringify(Object object);
 };
 
 #endif // INTERPRETER_H
\ No newline at end of file
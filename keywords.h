@@ -0,0 +1,72 @@
+/*
+ * keywords.h
+ * This file defines KeywordType, which tells the Scanner whether an identifier is one of the keywords of Lox.
+ *
+ * The keywords are found with a perfect hash built at compile time: the first character, five times the last character and the length,
+ * modulo KEYWORD_SLOTS, is different for every keyword. KeywordType hashes the identifier in place, without copying it, and compares it
+ * with the only keyword that can have that hash. A static_assert checks that the hash stays perfect if a keyword is added.
+ */
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include "token_type_enum.h"
+
+struct Keyword
+{
+    std::string_view text;
+    TokenType type = IDENTIFIER;
+};
+
+inline constexpr Keyword KEYWORDS[] = {
+    {"and", AND}, {"class", CLASS}, {"else", ELSE}, {"false", FALSE}, {"for", FOR}, {"fun", FUN}, {"if", IF}, {"nil", NIL},
+    {"or", OR}, {"print", PRINT}, {"return", RETURN}, {"super", SUPER}, {"this", THIS}, {"true", TRUE}, {"var", VAR}, {"while", WHILE}};
+
+inline constexpr size_t KEYWORD_SLOTS = 32;
+inline constexpr size_t KEYWORD_MIN_LENGTH = 2;
+inline constexpr size_t KEYWORD_MAX_LENGTH = 6;
+
+// the slot of a keyword; text must not be empty
+constexpr size_t KeywordHash(std::string_view text)
+{
+    return (static_cast<unsigned char>(text.front()) + 5 * static_cast<unsigned char>(text.back()) + text.size()) % KEYWORD_SLOTS;
+}
+
+constexpr bool KeywordHashIsPerfect()
+{
+    bool used[KEYWORD_SLOTS] = {};
+    for (const Keyword &keyword : KEYWORDS)
+    {
+        if (used[KeywordHash(keyword.text)] || keyword.text.size() < KEYWORD_MIN_LENGTH || keyword.text.size() > KEYWORD_MAX_LENGTH)
+            return false;
+        used[KeywordHash(keyword.text)] = true;
+    }
+    return true;
+}
+
+static_assert(KeywordHashIsPerfect(), "two keywords have the same hash");
+
+constexpr std::array<Keyword, KEYWORD_SLOTS> BuildKeywordTable()
+{
+    std::array<Keyword, KEYWORD_SLOTS> table{};
+    for (const Keyword &keyword : KEYWORDS)
+        table[KeywordHash(keyword.text)] = keyword;
+    return table;
+}
+
+inline constexpr std::array<Keyword, KEYWORD_SLOTS> KEYWORD_TABLE = BuildKeywordTable();
+
+// the type of the keyword spelled by text, or IDENTIFIER if it is not a keyword
+constexpr TokenType KeywordType(std::string_view text)
+{
+    if (text.size() < KEYWORD_MIN_LENGTH || text.size() > KEYWORD_MAX_LENGTH)
+        return IDENTIFIER;
+    const Keyword &keyword = KEYWORD_TABLE[KeywordHash(text)];
+    return keyword.text == text ? keyword.type : IDENTIFIER;
+}
+
+static_assert(KeywordType("while") == WHILE && KeywordType("or") == OR && KeywordType("whale") == IDENTIFIER);
+
+#endif // KEYWORDS_H
@@ -4,37 +4,66 @@
  * This file implements the Lox class defined in lox.h. The Lox class is the main entry point for the Lox interpreter.
  * It provides methods for running a Lox script from a file or from an interactive prompt.
  *
- * The RunFile method reads a Lox script from a file and executes it. If an error occurs during execution, the program exits with an error code.
+ * The RunFile method loads a Lox script with a SourceFile, which maps the file instead of copying it, and executes it. If an error occurs during execution, the program exits with an error code.
+ * A file longer than Token::MAX_SOURCE_SIZE is rejected before it is scanned, since the offsets of its tokens would not fit in a Token.
  *
  * The RunPrompt method starts an interactive prompt where the user can enter Lox commands, which are executed immediately.
  *
  * The Run method is a private helper method that takes a Lox script as a string and executes it. It performs lexical analysis, parsing, resolution, and interpretation.
  * If an error occurs during any of these stages, it sets the had_error flag and returns immediately.
+ * The resolved statements are simplified by the Optimizer before they run, on either engine.
+ * With the bytecode engine selected, the resolved statements are compiled by the Compiler and executed by the VM instead of the Interpreter.
+ * The syntax tree is parsed into an Arena local to Run, so it is freed in one operation whenever Run returns, including after an error.
+ * When requested, the garbage collector's statistics are printed to stderr once the program has run.
+ * With more than one scan thread, the Scanner scans the whole source in parallel before the Parser starts.
  */
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <vector>
 #include "lox.h"
 #include "token.h"
 #include "scanner.h"
 #include "error.h"
 #include "parser.h"
+#include "arena.h"
 #include "interpreter.h"
 #include "resolver.h"
+#include "optimizer.h"
+#include "compiler.h"
+#include "vm.h"
+#include "garbage_collector.h"
+#include "source_file.h"
 
+Lox::Engine Lox::engine = Lox::TREE_WALKER;
+bool Lox::print_gc_stats = false;
+unsigned Lox::scan_threads = 1;
+
+void Lox::SetEngine(Engine engine)
+{
+    Lox::engine = engine;
+}
+void Lox::SetGcStats(bool print)
+{
+    print_gc_stats = print;
+}
+void Lox::SetScanThreads(unsigned threads)
+{
+    scan_threads = threads;
+}
 void Lox::RunFile(const std::string &filePath)
 {
-    std::ifstream file(filePath);
-    if (!file.is_open())
+    SourceFile file;
+    if (!file.Open(filePath))
     {
         std::cerr << "Error opening file: " << filePath << std::endl;
         exit(1);
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    Run(buffer.str());
+    if (file.Text().size() > Token::MAX_SOURCE_SIZE)
+    {
+        std::cerr << "Source file too large." << std::endl;
+        exit(65);
+    }
+    Run(file.Text());
 
     if (had_error)
         exit(65);
@@ -58,33 +87,48 @@ void Lox::RunPrompt()
     }
 }
 
-void Lox::Run(const std::string &source)
+void Lox::Run(std::string_view source)
 {
     Scanner scanner(source);
-    std::vector<Token> tokens = scanner.ScanTokens();
-
-    Parser parser(tokens);
-    std::vector<Stmt *> statements = parser.Parse();
+    if (scan_threads > 1)
+        scanner.ScanInParallel(scan_threads);
+    Arena arena;
+    Parser parser(scanner, arena);
+    std::pmr::vector<Stmt *> statements = parser.Parse();
 
     if (had_error)
         return;
 
     Interpreter interpreter = Interpreter();
 
-    Resolver resolver = Resolver(&interpreter);
+    Resolver resolver = Resolver();
 
     resolver.Resolve(statements);
 
     if (had_error)
         return;
 
+    Optimizer optimizer(arena, resolver.MutableGlobals());
+    optimizer.Optimize(statements);
+
     // print ast
     // AstPrinter printer = AstPrinter();
     // for (auto statement : statements)
     //     printer.print(statement);
 
-    interpreter.Interpret(statements);
+    if (engine == BYTECODE_VM)
+    {
+        VM vm;
+        Compiler compiler(&vm);
+        ObjFunction *script = compiler.Compile(statements);
+        if (script != nullptr)
+            vm.Interpret(script);
+    }
+    else
+    {
+        interpreter.Interpret(statements);
+    }
 
-    for (auto statement : statements)
-        delete statement;
+    if (print_gc_stats)
+        GarbageCollector::Instance().PrintStats(std::cerr);
 }
@@ -8,21 +8,43 @@
  *
  * The RunPrompt method starts an interactive prompt where the user can enter Lox commands, which are executed immediately.
  *
- * The Run method is a private helper method that takes a Lox script as a string and executes it. This method is used by both RunFile and RunPrompt.
+ * The Run method is a private helper method that takes a view of a Lox script and executes it. This method is used by both RunFile and RunPrompt.
+ * The tokens refer to the script, so it must stay alive until Run returns.
+ *
+ * The SetEngine method selects how resolved programs are executed: by the tree-walking Interpreter (the default) or by compiling
+ * them to bytecode and running them on the VM.
+ *
+ * The SetGcStats method makes Run print the garbage collector's statistics to stderr after every program.
+ *
+ * The SetScanThreads method makes Run scan the whole source up front on that many threads, rather than as the Parser needs tokens.
  */
 #ifndef LOX_H
 #define LOX_H
 
 #include <string>
+#include <string_view>
 
 class Lox
 {
 public:
+    enum Engine
+    {
+        TREE_WALKER,
+        BYTECODE_VM
+    };
+
+    static void SetEngine(Engine engine);
+    static void SetGcStats(bool print);
+    static void SetScanThreads(unsigned threads);
     static void RunFile(const std::string &filePath);
     static void RunPrompt();
 
 private:
-    static void Run(const std::string &source);
+    static Engine engine;
+    static bool print_gc_stats;
+    static unsigned scan_threads;
+
+    static void Run(std::string_view source);
 };
 
 #endif // LOX_H
\ No newline at end of file
@@ -5,11 +5,9 @@
  *
  * The constructor initializes the class with a name, a superclass, and a map of methods.
  *
- * The destructor deletes the methods.
- *
  * The FindMethod method returns the method with the given name, or null if the method is not found. If the method is not found in the class, it looks for the method in the superclass.
  *
- * The Call method creates a new instance of the class and calls the initializer method, if it exists. The initializer method is bound to the instance before it is called.
+ * The Call method creates a new instance of the class and invokes the initializer method on it, if it exists.
  *
  * The Arity method returns the number of parameters the initializer method expects, or zero if the initializer method does not exist.
  *
@@ -24,13 +22,8 @@
 #include "lox_instance.h"
 #include "interpreter.h"
 
-LoxClass::LoxClass(std::string name, LoxClass *superclass, std::unordered_map<std::string, LoxFunction *> methods) : name(name), superclass(superclass), methods(methods) {}
-LoxClass::~LoxClass()
-{
-    for (auto it = methods.begin(); it != methods.end(); it++)
-        delete it->second;
-}
-LoxFunction *LoxClass::FindMethod(std::string name)
+LoxClass::LoxClass(std::string name, LoxClass *superclass, std::unordered_map<Symbol, LoxFunction *> methods) : name(name), superclass(superclass), methods(methods) {}
+LoxFunction *LoxClass::FindMethod(Symbol name)
 {
     auto it = methods.find(name);
     if (it != methods.end())
@@ -43,22 +36,31 @@ LoxFunction *LoxClass::FindMethod(std::string name)
     }
     return nullptr;
 }
-Object LoxClass::Call(Interpreter *interpreter, std::vector<Object> arguments)
+Object LoxClass::Call(Interpreter *interpreter, Arguments arguments)
 {
-    LoxInstance *instance = new LoxInstance(this); // instance在environment的析构函数中会被delete
-    LoxFunction *initializer = FindMethod("init");
+    LoxInstance *instance = GarbageCollector::Instance().Allocate<LoxInstance>(this);
+    LoxFunction *initializer = FindMethod(SymbolTable::INIT);
     if (initializer != nullptr)
     {
-        LoxFunction *temp = initializer->Bind(instance);
-        temp->Call(interpreter, arguments);
-        delete temp;
+        initializer->Invoke(interpreter, instance, arguments);
     }
     return instance;
 }
 
+void LoxClass::Trace(GarbageCollector &gc)
+{
+    gc.Mark(superclass);
+    for (auto it = methods.begin(); it != methods.end(); it++)
+        gc.Mark(it->second);
+}
+size_t LoxClass::Size() const
+{
+    return sizeof(LoxClass) + name.capacity() + MapSize(methods);
+}
+
 int LoxClass::Arity()
 {
-    LoxFunction *initializer = FindMethod("init");
+    LoxFunction *initializer = FindMethod(SymbolTable::INIT);
     if (initializer == nullptr)
         return 0;
     return initializer->Arity();
@@ -11,6 +11,8 @@
  * The Arity method returns zero, because classes are called without arguments to create a new instance.
  * The Get_name method returns the name of the class.
  * The ToString method returns a string representation of the class.
+ * The InstanceShape method returns the empty shape new instances start with; the class owns it and every shape derived from it.
+ * The Trace method marks the superclass and the methods for the garbage collector, and the Size method counts the name and the method map.
  */
 #ifndef LOXCLASS_H
 #define LOXCLASS_H
@@ -19,6 +21,7 @@
 #include <unordered_map>
 #include "visit_call_expr.h"
 #include "lox_function.h"
+#include "shape.h"
 
 class LoxFunction;
 
@@ -26,23 +29,29 @@ class LoxClass : public LoxCallable
 {
 public:
     LoxClass() = default;
-    LoxClass(std::string name, LoxClass *superclass, std::unordered_map<std::string, LoxFunction *> methods);
-    virtual ~LoxClass();
-    // returns the method with the given name, or null if the method is not found.
-    LoxFunction *FindMethod(std::string name);
+    LoxClass(std::string name, LoxClass *superclass, std::unordered_map<Symbol, LoxFunction *> methods);
+    // returns the method with the given symbol, or null if the method is not found.
+    LoxFunction *FindMethod(Symbol name);
     // creates a new instance of the class and calls the initializer method, if it exists.
-    Object Call(Interpreter *interpreter, std::vector<Object> arguments) override;
+    Object Call(Interpreter *interpreter, Arguments arguments) override;
     // return the number of parameters the initializer method expects, or zero if the initializer method does not exist.
     int Arity() override;
     // returns the name of the class.
     std::string Get_name();
     // returns a string representation of the class.
     std::string ToString();
+    // returns the shape of an instance without fields.
+    Shape *InstanceShape() { return &instance_shape; }
+    // marks the superclass and the methods.
+    void Trace(GarbageCollector &gc) override;
+    // returns the bytes of the class, its name and its method map.
+    size_t Size() const override;
 
 private:
-    std::string name;                                       // the name of the class
-    LoxClass *superclass;                                   // the superclass of the class
-    std::unordered_map<std::string, LoxFunction *> methods; // the methods of the class
+    std::string name;                                  // the name of the class
+    LoxClass *superclass;                              // the superclass of the class
+    std::unordered_map<Symbol, LoxFunction *> methods; // the methods of the class, by symbol
+    Shape instance_shape;                              // the root of the shapes of the class's instances
 };
 
 #endif // LOXCLASS_H
\ No newline at end of file
@@ -3,64 +3,65 @@
  * This file implements the LoxFunction class defined in lox_function.h.
  * The LoxFunction class represents a user-defined function in the Lox language.
  *
- * The constructor initializes the function with a Function declaration, an Environment pointer (representing the lexical environment where the function was defined),
- * and a boolean indicating whether it is an initializer of a class.
+ * The constructor initializes the function with the Function declaration it shares, the upvalues it captured,
+ * a boolean indicating whether it is an initializer of a class, and the receiver of a bound method.
  *
- * The destructor deletes the closure environment.
+ * The Bind method returns a bound method: the same declaration and upvalues, plus the instance to use as "this".
  *
- * The Bind method is used for methods to bind the instance to the function's environment.
+ * The Call method executes the function with the given arguments; for a bound method it invokes it on its receiver.
  *
- * The Call method executes the function with the given arguments. It creates a new environment for the function call, defines the function parameters in this environment,
- * and then executes the function body in this environment. If a return statement is encountered during execution, the function immediately returns the return value.
- * If the function is an initializer, it returns the instance ("this"). Otherwise, it returns null.
+ * The Invoke method starts a frame for the call on the interpreter's value stack, where the arguments already are. A method's "this" is slot 0
+ * of the frame, followed by the parameters, which is where the Resolver expects them. It then executes the function body in this frame. If the body completes with a return
+ * statement, the function takes the returned value from the interpreter. If the function is an initializer, it returns the instance ("this").
+ * Otherwise, it returns the returned value, or null.
  *
  * The Arity method returns the number of parameters the function expects.
  *
  * The ToString method returns a string representation of the function.
+ *
+ * Bound functions are allocated on the garbage-collected heap; nothing here frees them. The interpreter keeps the running function
+ * reachable while its body runs.
  */
 #include "lox_function.h"
-#include "return_method.h"
 #include "interpreter.h"
+#include "lox_instance.h"
 
-LoxFunction::LoxFunction(Function declaration, Environment *closure, bool isInitializer) : declaration(declaration), closure(closure), is_initializer(isInitializer) {}
-LoxFunction::~LoxFunction()
+LoxFunction::LoxFunction(const Function *declaration, std::vector<LoxUpvalue *> upvalues, bool isInitializer, LoxInstance *receiver)
+    : declaration(declaration), upvalues(std::move(upvalues)), is_initializer(isInitializer), receiver(receiver) {}
+LoxFunction *LoxFunction::Bind(LoxInstance *instance)
 {
-    delete closure;
+    return GarbageCollector::Instance().Allocate<LoxFunction>(declaration, upvalues, is_initializer, instance);
 }
-LoxFunction *LoxFunction::Bind(LoxInstance *instance)
+Object LoxFunction::Call(Interpreter *interpreter, Arguments arguments)
 {
-    Environment *environment = new Environment(closure); // environment在loxfuction的析构函数中会被delete
-    environment->Define("this", instance);
-    return new LoxFunction(declaration, environment, is_initializer); // loxfunction在调用的函数中会被delete
+    return Invoke(interpreter, receiver, arguments);
 }
-Object LoxFunction::Call(Interpreter *interpreter, std::vector<Object> arguments)
+Object LoxFunction::Invoke(Interpreter *interpreter, LoxInstance *receiver, Arguments arguments)
 {
-    Environment *environment = new Environment(closure);
-    for (std::vector<Token>::size_type i = 0; i < declaration.params.size(); i++)
-    {
-        environment->Define(declaration.params[i].lexeme, arguments[i]);
-    }
-    try
-    {
-        interpreter->ExecuteBlock(declaration.body, environment);
-        environment->Set_enclosing(nullptr);
-        delete environment;
-    }
-    catch (const Return_method &returnValue)
-    {
-        if (is_initializer)
-            return closure->GetAt(0, "this");
-        return returnValue.Get_value();
-    }
+    interpreter->PushFrame(this, receiver, arguments);
+    Object value = nullptr;
+    if (interpreter->ExecuteBlock(declaration->body) == Interpreter::Completion::RETURN)
+        value = interpreter->TakeReturnValue();
+    interpreter->PopFrame();
     if (is_initializer)
-        return closure->GetAt(0, "this");
-    return nullptr;
+        return receiver;
+    return value;
+}
+void LoxFunction::Trace(GarbageCollector &gc)
+{
+    for (LoxUpvalue *upvalue : upvalues)
+        gc.Mark(upvalue);
+    gc.Mark(receiver);
+}
+size_t LoxFunction::Size() const
+{
+    return sizeof(LoxFunction) + upvalues.capacity() * sizeof(LoxUpvalue *);
 }
 int LoxFunction::Arity()
 {
-    return declaration.params.size();
+    return declaration->params.size();
 }
 std::string LoxFunction::ToString()
 {
-    return "<fn " + declaration.name.lexeme + ">";
+    return "<fn " + std::string(declaration->name.Lexeme()) + ">";
 }
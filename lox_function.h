@@ -1,22 +1,32 @@
 /*
  * lox_function.h
  * This file defines the LoxFunction class, which represents a user-defined function in the Lox language.
- * Each LoxFunction has a Function declaration, an Environment pointer (representing the lexical environment where the function was defined),
- * and a boolean indicating whether it is an initializer of a class.
+ * Each LoxFunction has a pointer to its Function declaration, the upvalues it captured when it was created (the locals of enclosing
+ * functions that it uses), a boolean indicating whether it is an initializer of a class, and for a bound method, the instance it was bound to.
  *
  * The LoxFunction class provides methods for binding an instance (for methods), calling the function, getting the arity (number of parameters),
  * and converting the function to a string.
  *
- * The Bind method is used for methods to bind the instance to the function's environment.
+ * The declaration is the prototype every closure and bound method of the function shares: it is created once, by the Parser, in the
+ * Arena of the syntax tree, and the Resolver's annotations make it the same for every call, so it is never copied or changed here.
+ * Creating a closure or binding a method therefore costs the same whatever the size of the function.
+ *
+ * A closure holds only the upvalues its declaration lists, not the frames they came from, so it keeps alive no local it does not use.
+ *
+ * The Bind method returns a bound method that shares the declaration and upvalues and remembers the instance it was read from.
  * The Call method executes the function with the given arguments.
+ * The Invoke method executes a method with the given instance as "this", without creating a bound method first.
+ * The GetUpvalue method returns one of the upvalues, by the index the Resolver gave it.
  * The Arity method returns the number of parameters the function expects.
  * The ToString method returns a string representation of the function.
+ * The Trace method marks the upvalues and the receiver for the garbage collector, and the Size method counts the upvalue array.
  */
 #ifndef LOX_FUNCTION_H
 #define LOX_FUNCTION_H
 
+#include <vector>
 #include "visit_call_expr.h"
-#include "environment.h"
+#include "lox_upvalue.h"
 #include "expr.h"
 
 class Interpreter;
@@ -25,19 +35,27 @@ class LoxFunction : public LoxCallable
 {
 public:
     LoxFunction() = default;
-    LoxFunction(Function declaration, Environment *closure, bool isInitializer);
-    ~LoxFunction();
-    // used for methods to bind the instance to the function's environment.
+    LoxFunction(const Function *declaration, std::vector<LoxUpvalue *> upvalues, bool isInitializer, LoxInstance *receiver = nullptr);
+    // used for methods to bind the instance they are called on.
     LoxFunction *Bind(LoxInstance *instance);
     // executes the function with the given arguments.
-    Object Call(Interpreter *interpreter, std::vector<Object> arguments);
+    Object Call(Interpreter *interpreter, Arguments arguments);
+    // executes a method with the given instance as "this".
+    Object Invoke(Interpreter *interpreter, LoxInstance *receiver, Arguments arguments);
     // returns the number of parameters the function expects.
     int Arity();
+    // returns the upvalue with the given index.
+    LoxUpvalue *GetUpvalue(int index) const { return upvalues[index]; }
+    // marks the upvalues and the receiver.
+    void Trace(GarbageCollector &gc) override;
+    // returns the bytes of the function and its upvalue array.
+    size_t Size() const override;
 
 private:
-    Function declaration; // the function declaration
-    Environment *closure; // the lexical environment where the function was defined
-    bool is_initializer;  // whether it is an initializer of a class
+    const Function *declaration = nullptr; // the function declaration, shared with every closure and bound method of the function
+    std::vector<LoxUpvalue *> upvalues; // the captured locals of the enclosing functions, in the order of declaration->upvalues
+    bool is_initializer = false;     // whether it is an initializer of a class
+    LoxInstance *receiver = nullptr; // the instance a bound method was bound to; nullptr for functions and for the methods stored in a class
     // returns a string representation of the function.
     std::string ToString();
 };
@@ -2,34 +2,98 @@
  * lox_instance.cpp
  * This file implements the LoxInstance class defined in lox_instance.h.
  * The LoxInstance class represents an instance of a user-defined class in the Lox language.
- * Each LoxInstance has a reference to its class (of type LoxClass), and a map of fields that store the instance's variables.
+ * Each LoxInstance has a reference to its class (of type LoxClass), a shape, and an array of field values.
  *
- * The Set method sets the value of a field.
- * The Get method returns the value of a field, or throws a RuntimeError if the field is not defined.
+ * The constructor starts the instance at its class's empty shape.
+ * The Set method sets the value of a field, moving the instance to a new shape if the field is new.
+ * The Get method returns the value of a field, or a method bound to the instance, or throws a RuntimeError if neither is defined.
+ * The FindProperty method returns the method a property names, or stores the value of the field it names and returns nullptr.
+ * Get and FindProperty consult the access site's inline cache first, and record what the slow path resolved for the current shape.
  * The ToString method returns a string representation of the instance.
+ * The Trace method marks the class and every field value. The Size method counts every slot the field array has room for.
  */
 #include "lox_instance.h"
 #include "runtime_error.h"
 
-LoxInstance::LoxInstance(LoxClass *klass) : klass(klass) {}
+LoxInstance::LoxInstance(LoxClass *klass) : klass(klass), shape(klass->InstanceShape()) {}
 
-void LoxInstance::Set(Token name, Object value)
+void LoxInstance::Set(const Token &name, Object value, PropertyCache &cache)
 {
-    fields[name.lexeme] = value;
+    const PropertyCache::Entry *entry = cache.Find(shape->Id());
+    if (entry != nullptr)
+    {
+        if (entry->next_shape == nullptr)
+        {
+            fields[entry->slot] = value;
+        }
+        else
+        {
+            shape = entry->next_shape;
+            fields.push_back(value);
+        }
+        return;
+    }
+
+    uint64_t shape_id = shape->Id();
+    int slot = shape->Find(name.symbol);
+    if (slot >= 0)
+    {
+        fields[slot] = value;
+        cache.Add({shape_id, slot, nullptr, nullptr});
+        return;
+    }
+    shape = shape->AddField(name.symbol);
+    fields.push_back(value);
+    cache.Add({shape_id, static_cast<int>(fields.size()) - 1, nullptr, shape});
+}
+Object LoxInstance::Get(const Token &name, PropertyCache &cache)
+{
+    Object field;
+    LoxFunction *method = FindProperty(name, cache, field);
+    if (method != nullptr)
+        return method->Bind(this);
+    return field;
 }
-Object LoxInstance::Get(Token name)
+LoxFunction *LoxInstance::FindProperty(const Token &name, PropertyCache &cache, Object &field)
 {
-    if (fields.find(name.lexeme) != fields.end())
-        return fields[name.lexeme];
+    const PropertyCache::Entry *entry = cache.Find(shape->Id());
+    if (entry != nullptr)
+    {
+        if (entry->slot >= 0)
+            field = fields[entry->slot];
+        return entry->method;
+    }
+
+    int slot = shape->Find(name.symbol);
+    if (slot >= 0)
+    {
+        cache.Add({shape->Id(), slot, nullptr, nullptr});
+        field = fields[slot];
+        return nullptr;
+    }
 
-    LoxFunction *method = klass->FindMethod(name.lexeme);
+    LoxFunction *method = klass->FindMethod(name.symbol);
 
     if (method != nullptr)
-        return method->Bind(this);
+    {
+        cache.Add({shape->Id(), -1, method, nullptr});
+        return method;
+    }
 
-    throw RuntimeError(name, "Undefined property '" + name.lexeme + "'.");
+    throw RuntimeError(name, "Undefined property '" + std::string(name.Lexeme()) + "'.");
 }
 std::string LoxInstance::ToString()
 {
     return klass->Get_name() + " instance";
 }
+
+void LoxInstance::Trace(GarbageCollector &gc)
+{
+    gc.Mark(klass);
+    for (const Object &field : fields)
+        gc.MarkValue(field);
+}
+size_t LoxInstance::Size() const
+{
+    return sizeof(LoxInstance) + fields.capacity() * sizeof(Object);
+}
@@ -5,34 +5,51 @@
  * File: lox_instance.h
  * ---------------------
  * This file defines the LoxInstance class, which represents an instance of a user-defined class in the Lox language.
- * Each LoxInstance has a reference to its class (of type LoxClass), and a map of fields that store the instance's variables.
+ * Each LoxInstance has a reference to its class (of type LoxClass), a shape, and an array of field values.
+ * The shape (see shape.h) maps field names to indexes in the array and is shared by every instance with the same fields.
  *
  * The LoxInstance class provides methods for setting and getting field values, and for converting the instance to a string.
  *
  * The Set method takes a token (representing the variable name) and an object (representing the value), and sets the field accordingly.
+ * Setting a new field moves the instance to the next shape and appends the value.
  *
  * The Get method takes a token (representing the variable name) and returns the corresponding value.
  *
+ * The FindProperty method looks a property up without binding methods: it returns the method, or stores the field's value and returns nullptr.
+ * A call like instance.name(args) uses it to invoke a method directly on the instance.
+ *
+ * Both take the inline cache of the expression that accesses the property. On a hit for the instance's shape they skip the lookups
+ * by name: a field is an indexed load or store, a method needs no walk up the superclass chain, and adding a field reuses the
+ * transition found the first time.
+ *
  * The ToString method returns a string representation of the instance, which includes the class name and the instance's memory address.
+ *
+ * The Trace method marks the class and the field values for the garbage collector, and the Size method counts the field array.
  */
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "lox_class.h"
+#include "shape.h"
+#include "property_cache.h"
+#include "garbage_collector.h"
 
-class LoxInstance
+class LoxInstance : public GcObject
 {
 public:
     LoxInstance(){};
     LoxInstance(LoxClass *klass);
-    virtual ~LoxInstance(){};
-    void Set(Token name, Object value);
-    Object Get(Token name);
+    void Set(const Token &name, Object value, PropertyCache &cache);
+    Object Get(const Token &name, PropertyCache &cache);
+    LoxFunction *FindProperty(const Token &name, PropertyCache &cache, Object &field);
     std::string ToString();
+    void Trace(GarbageCollector &gc) override;
+    size_t Size() const override;
 
 private:
     LoxClass *klass;
-    // An unordered_map storing the fields of the Lox instance.The key is the field name and the value is the field value.
-    std::unordered_map<std::string, Object> fields;
+    Shape *shape;               // the layout of the fields, owned by the class
+    std::vector<Object> fields; // the field values, in the slots the shape assigns
 };
 
 #endif // LOXINSTANCE_H
@@ -0,0 +1,19 @@
+/*
+ * lox_string.cpp
+ * This file implements the LoxString class defined in lox_string.h.
+ *
+ * The constructor takes ownership of the characters and their hash. The Trace method does nothing, because a string references no other object.
+ * The Size method counts the characters along with the object, so a string is charged to the heap for its whole length when it is
+ * interned and its characters are subtracted when the collector frees it.
+ */
+#include "lox_string.h"
+
+LoxString::LoxString(std::string chars, uint32_t hash) : chars(std::move(chars)), hash(hash) {}
+
+void LoxString::Trace(GarbageCollector &)
+{
+}
+size_t LoxString::Size() const
+{
+    return sizeof(LoxString) + chars.size();
+}
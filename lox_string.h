@@ -0,0 +1,35 @@
+/*
+ * lox_string.h
+ * This file defines the LoxString class, the heap object holding the characters of a string value of the tree-walking interpreter.
+ *
+ * A LoxString is immutable and interned: only the StringTable creates them, so two LoxStrings never have the same characters and
+ * strings compare by identity. Each one stores the hash of its characters, computed once by the StringTable.
+ *
+ * Like every runtime object it is allocated through the garbage collector, and it references no other object, so its Trace method
+ * marks nothing.
+ */
+#ifndef LOX_STRING_H
+#define LOX_STRING_H
+
+#include <cstdint>
+#include <string>
+#include "garbage_collector.h"
+
+class LoxString : public GcObject
+{
+public:
+    void Trace(GarbageCollector &gc) override;
+    // returns the bytes of the string and its characters
+    size_t Size() const override;
+
+    const std::string chars; // the characters of the string
+    const uint32_t hash;     // the StringTable hash of chars
+
+private:
+    friend class GarbageCollector;
+    friend class StringTable;
+
+    LoxString(std::string chars, uint32_t hash);
+};
+
+#endif // LOX_STRING_H
@@ -0,0 +1,14 @@
+/*
+ * lox_upvalue.cpp
+ * This file implements the LoxUpvalue class defined in lox_upvalue.h.
+ *
+ * The constructor takes the value the local had when it was captured. The Trace method marks it.
+ */
+#include "lox_upvalue.h"
+
+LoxUpvalue::LoxUpvalue(Object value) : value(value) {}
+
+void LoxUpvalue::Trace(GarbageCollector &gc)
+{
+    gc.MarkValue(value);
+}
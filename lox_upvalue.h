@@ -0,0 +1,28 @@
+/*
+ * lox_upvalue.h
+ * This file defines the LoxUpvalue class, the heap cell holding a local variable that a closure captured.
+ *
+ * Locals live in the slots of their function's frame on the interpreter's value stack, and disappear with it. When a function is created
+ * that uses a local of an enclosing function, the local is hoisted into a LoxUpvalue: the cell takes the local's value and then its
+ * place in the slot, and the new closure keeps a pointer to the same cell. From then on the enclosing function and every closure that
+ * captured the local read and assign it through the cell, and the cell outlives the frame for as long as a closure holds it.
+ * Locals that no closure captures are never hoisted.
+ *
+ * Like every runtime object it is allocated through the garbage collector; the Trace method marks the value it holds.
+ */
+#ifndef LOX_UPVALUE_H
+#define LOX_UPVALUE_H
+
+#include "garbage_collector.h"
+
+class LoxUpvalue : public GcObject
+{
+public:
+    LoxUpvalue(Object value);
+    void Trace(GarbageCollector &gc) override;
+    size_t Size() const override { return sizeof(LoxUpvalue); }
+
+    Object value; // the current value of the captured local
+};
+
+#endif // LOX_UPVALUE_H
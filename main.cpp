@@ -2,6 +2,10 @@
  * main.cpp
  * This is the main entry point for the application.
  * It handles command line arguments and decides whether to run a Lox script from a file or start a REPL.
+ * The --vm flag runs programs on the bytecode VM instead of the tree-walking interpreter.
+ * The --gc-stats flag prints the garbage collector's statistics after the program, and --gc-threshold=<bytes> sets the heap size
+ * that triggers the first collection.
+ * The --scan-threads=<n> flag scans the source on n threads before parsing it.
  *
  * Author: Galle
  * Date: 2023-12-23
@@ -12,17 +16,36 @@
 #include "scanner.h"
 #include "lox.h"
 #include "ast_printer.h"
+#include "garbage_collector.h"
 
 int main(int argc, char const *argv[])
 {
-    if (argc > 2)
+    const std::string threshold_flag = "--gc-threshold=";
+    const std::string scan_threads_flag = "--scan-threads=";
+    int arg = 1;
+    for (; arg < argc && std::string(argv[arg]).compare(0, 2, "--") == 0; arg++)
     {
-        std::cerr << "Usage: ./cpplox [script]" << std::endl;
+        std::string flag = argv[arg];
+        if (flag == "--vm")
+            Lox::SetEngine(Lox::BYTECODE_VM);
+        else if (flag == "--gc-stats")
+            Lox::SetGcStats(true);
+        else if (flag.compare(0, threshold_flag.size(), threshold_flag) == 0)
+            GarbageCollector::Instance().SetThreshold(std::stoul(flag.substr(threshold_flag.size())));
+        else if (flag.compare(0, scan_threads_flag.size(), scan_threads_flag) == 0)
+            Lox::SetScanThreads(std::stoul(flag.substr(scan_threads_flag.size())));
+        else
+            break;
+    }
+
+    if (argc - arg > 1 || (arg < argc && std::string(argv[arg]).compare(0, 2, "--") == 0))
+    {
+        std::cerr << "Usage: ./cpplox [--vm] [--gc-stats] [--gc-threshold=<bytes>] [--scan-threads=<n>] [script]" << std::endl;
         return 64;
     }
-    else if (argc == 2)
+    else if (argc - arg == 1)
     {
-        Lox::RunFile(argv[1]);
+        Lox::RunFile(argv[arg]);
     }
     else
     {
@@ -0,0 +1,126 @@
+/*
+ * object.h
+ * This file defines the Object class, the value of every expression of the tree-walking interpreter.
+ *
+ * An Object is 8 bytes: it is NaN-boxed. A number is stored as the bits of its double. Every other value is stored as a quiet NaN
+ * with the sign bit clear and a nonzero tag in bits 48-50, and the low 48 bits as its payload: 0 or 1 for a boolean, the address for a
+ * pointer to a heap string, callable, class, instance or upvalue. Arithmetic never produces such a NaN, because the Number constructor
+ * replaces every NaN with the canonical one, whose tag bits are zero.
+ *
+ * The constructors are implicit, so a double, a bool, nullptr or one of the heap pointers can be returned wherever an Object is expected.
+ * Any other pointer is rejected at compile time instead of silently converting to bool.
+ *
+ * The Is... methods test the kind of value and the As... methods read it back; an As... method must only be called after the matching Is...
+ *
+ * An upvalue is never the value of an expression: it only takes the place of a captured local in its slot of the interpreter's value
+ * stack (see lox_upvalue.h), and reading or assigning the local goes through it.
+ *
+ * Undefined is the value of a global that has not been defined yet (see environment.h). It is a nil with a payload of 1, so it is never
+ * the value of an expression: a global holding it is reported as undefined before its value is used.
+ *
+ * Two Objects are equal if they are equal numbers, or if they have the same bits: the same boolean, both nil, or the same heap object.
+ * Strings are interned by the StringTable, so strings with the same characters are the same heap object.
+ */
+#ifndef OBJECT_H
+#define OBJECT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+class LoxString;
+class LoxCallable;
+class LoxClass;
+class LoxInstance;
+class LoxUpvalue;
+
+class Object
+{
+public:
+    Object() : bits(Box(TAG_NIL, 0)) {}
+    Object(std::nullptr_t) : bits(Box(TAG_NIL, 0)) {}
+    Object(bool boolean) : bits(Box(TAG_BOOL, boolean ? 1 : 0)) {}
+    Object(double number)
+    {
+        if (number != number)
+            number = CanonicalNaN();
+        std::memcpy(&bits, &number, sizeof(double));
+    }
+    Object(LoxString *string) : bits(Box(TAG_STRING, reinterpret_cast<uintptr_t>(string))) {}
+    Object(LoxCallable *callable) : bits(Box(TAG_CALLABLE, reinterpret_cast<uintptr_t>(callable))) {}
+    Object(LoxClass *klass) : bits(Box(TAG_CLASS, reinterpret_cast<uintptr_t>(klass))) {}
+    Object(LoxInstance *instance) : bits(Box(TAG_INSTANCE, reinterpret_cast<uintptr_t>(instance))) {}
+    Object(LoxUpvalue *upvalue) : bits(Box(TAG_UPVALUE, reinterpret_cast<uintptr_t>(upvalue))) {}
+    Object(const void *pointer) = delete;
+    static Object Undefined()
+    {
+        Object object;
+        object.bits = Box(TAG_NIL, 1);
+        return object;
+    }
+
+    bool IsNumber() const { return (bits & BOX_MASK) != BOX || (bits & TAG_MASK) == 0; }
+    bool IsNil() const { return HasTag(TAG_NIL); }
+    bool IsBool() const { return HasTag(TAG_BOOL); }
+    bool IsString() const { return HasTag(TAG_STRING); }
+    bool IsCallable() const { return HasTag(TAG_CALLABLE); }
+    bool IsClass() const { return HasTag(TAG_CLASS); }
+    bool IsInstance() const { return HasTag(TAG_INSTANCE); }
+    bool IsUpvalue() const { return HasTag(TAG_UPVALUE); }
+    bool IsUndefined() const { return bits == Box(TAG_NIL, 1); }
+
+    double AsNumber() const
+    {
+        double number;
+        std::memcpy(&number, &bits, sizeof(double));
+        return number;
+    }
+    bool AsBool() const { return (bits & PAYLOAD_MASK) != 0; }
+    LoxString *AsString() const { return reinterpret_cast<LoxString *>(bits & PAYLOAD_MASK); }
+    LoxCallable *AsCallable() const { return reinterpret_cast<LoxCallable *>(bits & PAYLOAD_MASK); }
+    LoxClass *AsClass() const { return reinterpret_cast<LoxClass *>(bits & PAYLOAD_MASK); }
+    LoxInstance *AsInstance() const { return reinterpret_cast<LoxInstance *>(bits & PAYLOAD_MASK); }
+    LoxUpvalue *AsUpvalue() const { return reinterpret_cast<LoxUpvalue *>(bits & PAYLOAD_MASK); }
+
+    bool operator==(const Object &other) const
+    {
+        if (IsNumber() && other.IsNumber())
+            return AsNumber() == other.AsNumber();
+        return bits == other.bits;
+    }
+    bool operator!=(const Object &other) const { return !(*this == other); }
+
+private:
+    static const uint64_t BOX_MASK = 0xfff8000000000000;     // the sign, the exponent and the quiet bit
+    static const uint64_t BOX = 0x7ff8000000000000;          // a positive quiet NaN
+    static const uint64_t TAG_MASK = 0x0007000000000000;     // bits 48-50
+    static const uint64_t PAYLOAD_MASK = 0x0000ffffffffffff; // the low 48 bits
+    static const int TAG_SHIFT = 48;
+
+    enum Tag : uint64_t
+    {
+        TAG_NIL = 1,
+        TAG_BOOL,
+        TAG_STRING,
+        TAG_CALLABLE,
+        TAG_CLASS,
+        TAG_INSTANCE,
+        TAG_UPVALUE
+    };
+
+    uint64_t bits;
+
+    static uint64_t Box(Tag tag, uint64_t payload) { return BOX | (static_cast<uint64_t>(tag) << TAG_SHIFT) | payload; }
+    static double CanonicalNaN()
+    {
+        double number;
+        uint64_t nan = BOX;
+        std::memcpy(&number, &nan, sizeof(double));
+        return number;
+    }
+    bool HasTag(Tag tag) const { return (bits & (BOX_MASK | TAG_MASK)) == (BOX | (static_cast<uint64_t>(tag) << TAG_SHIFT)); }
+};
+
+static_assert(sizeof(Object) == 8, "an Object must fit in a register");
+
+#endif // OBJECT_H
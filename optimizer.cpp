@@ -0,0 +1,314 @@
+/*
+ * optimizer.cpp
+ * This file implements the Optimizer class defined in optimizer.h.
+ *
+ * Each Visit... method optimizes the children of a node first, replacing them by what they were optimized to, and then leaves what the
+ * node itself is replaced by in expr_result or stmt_result: the node, a new Literal, one of its children, or for a statement nullptr
+ * to remove it. The Optimize methods visit a node and return that replacement.
+ *
+ * Binary and Unary expressions with Literal operands are evaluated as the Interpreter would, except where the Interpreter would throw a
+ * RuntimeError; they are then left alone. A Logical expression with a Literal left operand is replaced by the operand it would return.
+ *
+ * A top-level Var whose initializer is a Literal, or that has none, makes its global a constant, unless the Resolver saw it assigned or
+ * declared again. Every read of the global that comes later in the source is replaced by the constant: code after the declaration can
+ * only run once the declaration has, since the top level runs in order and a function can only be called after it is declared. Reads
+ * that come earlier are left alone, so reading the global before it is defined is still an error.
+ *
+ * Removing statements never changes the slots of locals: an If or a While only ever contains statements, and a declaration inside one is
+ * always in a Block, whose scope goes with it.
+ */
+#include "optimizer.h"
+#include "interpreter.h"
+#include "lox_string.h"
+#include "string_table.h"
+
+Optimizer::Optimizer(Arena &arena, const std::unordered_set<Symbol> &mutable_globals) : arena(arena), mutable_globals(mutable_globals)
+{
+    GarbageCollector::Instance().AddRootSource(this);
+}
+Optimizer::~Optimizer()
+{
+    GarbageCollector::Instance().RemoveRootSource(this);
+}
+void Optimizer::Optimize(std::pmr::vector<Stmt *> &statements)
+{
+    OptimizeList(statements);
+}
+void Optimizer::MarkRoots(GarbageCollector &gc)
+{
+    for (LoxString *string : strings)
+        gc.Mark(string);
+}
+
+Expr *Optimizer::Optimize(Expr *expr)
+{
+    expr->Accept(*this);
+    return expr_result;
+}
+Stmt *Optimizer::Optimize(Stmt *stmt)
+{
+    stmt->Accept(*this);
+    return stmt_result;
+}
+Stmt *Optimizer::OptimizeBody(Stmt *stmt)
+{
+    Stmt *optimized = Optimize(stmt);
+    if (optimized == nullptr)
+        return arena.New<Block>(std::pmr::vector<Stmt *>(arena.Resource()));
+    return optimized;
+}
+void Optimizer::OptimizeList(std::pmr::vector<Stmt *> &statements)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < statements.size(); i++)
+    {
+        Stmt *optimized = Optimize(statements[i]);
+        if (optimized != nullptr)
+            statements[kept++] = optimized;
+    }
+    statements.resize(kept);
+}
+Literal *Optimizer::MakeLiteral(Object value)
+{
+    return arena.New<Literal>(value);
+}
+
+Object Optimizer::VisitAssignExpr(Assign &expr)
+{
+    expr.value = Optimize(expr.value);
+    expr_result = &expr;
+    return nullptr;
+}
+Object Optimizer::VisitBinaryExpr(Binary &expr)
+{
+    expr.left = Optimize(expr.left);
+    expr.right = Optimize(expr.right);
+    expr_result = &expr;
+
+    Literal *left = dynamic_cast<Literal *>(expr.left);
+    Literal *right = dynamic_cast<Literal *>(expr.right);
+    if (left == nullptr || right == nullptr)
+        return nullptr;
+
+    Object a = left->value;
+    Object b = right->value;
+    bool numbers = a.IsNumber() && b.IsNumber();
+    switch (expr.op.type)
+    {
+    case GREATER:
+        if (numbers)
+            expr_result = MakeLiteral(a.AsNumber() > b.AsNumber());
+        break;
+    case GREATER_EQUAL:
+        if (numbers)
+            expr_result = MakeLiteral(a.AsNumber() >= b.AsNumber());
+        break;
+    case LESS:
+        if (numbers)
+            expr_result = MakeLiteral(a.AsNumber() < b.AsNumber());
+        break;
+    case LESS_EQUAL:
+        if (numbers)
+            expr_result = MakeLiteral(a.AsNumber() <= b.AsNumber());
+        break;
+    case MINUS:
+        if (numbers)
+            expr_result = MakeLiteral(a.AsNumber() - b.AsNumber());
+        break;
+    case PLUS:
+        if (numbers)
+        {
+            expr_result = MakeLiteral(a.AsNumber() + b.AsNumber());
+        }
+        else if (a.IsString() && b.IsString())
+        {
+            LoxString *string = StringTable::Instance().Intern(a.AsString()->chars + b.AsString()->chars);
+            strings.push_back(string);
+            expr_result = MakeLiteral(string);
+        }
+        break;
+    case SLASH:
+        if (numbers)
+            expr_result = MakeLiteral(a.AsNumber() / b.AsNumber());
+        break;
+    case STAR:
+        if (numbers)
+            expr_result = MakeLiteral(a.AsNumber() * b.AsNumber());
+        break;
+    case BANG_EQUAL:
+        expr_result = MakeLiteral(!Interpreter::IsEqual(a, b));
+        break;
+    case EQUAL_EQUAL:
+        expr_result = MakeLiteral(Interpreter::IsEqual(a, b));
+        break;
+    default:
+        break;
+    }
+    return nullptr;
+}
+Object Optimizer::VisitCallExpr(Call &expr)
+{
+    expr.callee = Optimize(expr.callee);
+    for (Expr *&argument : expr.arguments)
+        argument = Optimize(argument);
+    expr_result = &expr;
+    return nullptr;
+}
+Object Optimizer::VisitGetExpr(Get &expr)
+{
+    expr.object = Optimize(expr.object);
+    expr_result = &expr;
+    return nullptr;
+}
+Object Optimizer::VisitGroupingExpr(Grouping &expr)
+{
+    expr_result = Optimize(expr.expression);
+    return nullptr;
+}
+Object Optimizer::VisitLiteralExpr(Literal &expr)
+{
+    expr_result = &expr;
+    return nullptr;
+}
+Object Optimizer::VisitLogicalExpr(Logical &expr)
+{
+    expr.left = Optimize(expr.left);
+    expr.right = Optimize(expr.right);
+    expr_result = &expr;
+
+    // "or" returns a truthy left operand and "and" a falsy one; otherwise both return the right operand
+    if (Literal *left = dynamic_cast<Literal *>(expr.left))
+        expr_result = (expr.op.type == OR) == Interpreter::IsTruthy(left->value) ? expr.left : expr.right;
+    return nullptr;
+}
+Object Optimizer::VisitSetExpr(Set &expr)
+{
+    expr.object = Optimize(expr.object);
+    expr.value = Optimize(expr.value);
+    expr_result = &expr;
+    return nullptr;
+}
+Object Optimizer::VisitSuperExpr(Super &expr)
+{
+    expr_result = &expr;
+    return nullptr;
+}
+Object Optimizer::VisitThisExpr(This &expr)
+{
+    expr_result = &expr;
+    return nullptr;
+}
+Object Optimizer::VisitUnaryExpr(Unary &expr)
+{
+    expr.right = Optimize(expr.right);
+    expr_result = &expr;
+
+    if (Literal *right = dynamic_cast<Literal *>(expr.right))
+    {
+        if (expr.op.type == BANG)
+            expr_result = MakeLiteral(!Interpreter::IsTruthy(right->value));
+        else if (expr.op.type == MINUS && right->value.IsNumber())
+            expr_result = MakeLiteral(-right->value.AsNumber());
+    }
+    return nullptr;
+}
+Object Optimizer::VisitVariableExpr(Variable &expr)
+{
+    expr_result = &expr;
+    if (expr.binding.kind == Binding::GLOBAL)
+    {
+        auto it = constants.find(expr.name.symbol);
+        if (it != constants.end())
+            expr_result = MakeLiteral(it->second);
+    }
+    return nullptr;
+}
+
+Object Optimizer::VisitBlockStmt(Block &stmt)
+{
+    depth++;
+    OptimizeList(stmt.statements);
+    depth--;
+    stmt_result = &stmt;
+    return nullptr;
+}
+Object Optimizer::VisitClassStmt(Class &stmt)
+{
+    for (Function *method : stmt.methods)
+        Optimize(method);
+    stmt_result = &stmt;
+    return nullptr;
+}
+Object Optimizer::VisitExpressionStmt(Expression &stmt)
+{
+    stmt.expression = Optimize(stmt.expression);
+    // a constant expression does nothing
+    stmt_result = dynamic_cast<Literal *>(stmt.expression) != nullptr ? nullptr : &stmt;
+    return nullptr;
+}
+Object Optimizer::VisitFunctionStmt(Function &stmt)
+{
+    depth++;
+    OptimizeList(stmt.body);
+    depth--;
+    stmt_result = &stmt;
+    return nullptr;
+}
+Object Optimizer::VisitIfStmt(If &stmt)
+{
+    stmt.condition = Optimize(stmt.condition);
+    if (Literal *condition = dynamic_cast<Literal *>(stmt.condition))
+    {
+        Stmt *branch = Interpreter::IsTruthy(condition->value) ? stmt.thenBranch : stmt.elseBranch;
+        stmt_result = branch != nullptr ? Optimize(branch) : nullptr;
+        return nullptr;
+    }
+
+    stmt.thenBranch = OptimizeBody(stmt.thenBranch);
+    if (stmt.elseBranch != nullptr)
+        stmt.elseBranch = Optimize(stmt.elseBranch);
+    stmt_result = &stmt;
+    return nullptr;
+}
+Object Optimizer::VisitPrintStmt(Print &stmt)
+{
+    stmt.expression = Optimize(stmt.expression);
+    stmt_result = &stmt;
+    return nullptr;
+}
+Object Optimizer::VisitReturnStmt(Return &stmt)
+{
+    if (stmt.value != nullptr)
+        stmt.value = Optimize(stmt.value);
+    stmt_result = &stmt;
+    return nullptr;
+}
+Object Optimizer::VisitVarStmt(Var &stmt)
+{
+    if (stmt.initializer != nullptr)
+        stmt.initializer = Optimize(stmt.initializer);
+
+    if (depth == 0 && mutable_globals.count(stmt.name.symbol) == 0)
+    {
+        if (stmt.initializer == nullptr)
+            constants[stmt.name.symbol] = nullptr;
+        else if (Literal *initializer = dynamic_cast<Literal *>(stmt.initializer))
+            constants[stmt.name.symbol] = initializer->value;
+    }
+    stmt_result = &stmt;
+    return nullptr;
+}
+Object Optimizer::VisitWhileStmt(While &stmt)
+{
+    stmt.condition = Optimize(stmt.condition);
+    Literal *condition = dynamic_cast<Literal *>(stmt.condition);
+    if (condition != nullptr && !Interpreter::IsTruthy(condition->value))
+    {
+        stmt_result = nullptr;
+        return nullptr;
+    }
+
+    stmt.body = OptimizeBody(stmt.body);
+    stmt_result = &stmt;
+    return nullptr;
+}
@@ -0,0 +1,76 @@
+/*
+ * optimizer.h
+ * This file defines the Optimizer class, a pass that simplifies the resolved syntax tree before it runs.
+ *
+ * The Optimizer folds the expressions whose operands are all constants into Literals, drops Grouping nodes, replaces an If or While
+ * whose condition is constant by the branch that would run, or removes it, and replaces the reads of a global that is never assigned
+ * or redeclared by the constant it was declared with.
+ * It never folds an operation that would fail at runtime, such as "a" - 1, so the error still happens when, and if, the program gets there.
+ * Statements that were removed leave an empty Block where a statement is required.
+ *
+ * The Optimize method rewrites a program in place; the nodes it creates come from the Arena the program was parsed into.
+ * The strings made by folding a concatenation are interned like the Scanner's literals, and the Optimizer, a root source of the garbage
+ * collector, keeps them alive, so it must live as long as the program runs.
+ */
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "expr.h"
+#include "arena.h"
+#include "garbage_collector.h"
+
+class Optimizer : public Visitor, public GcRootSource
+{
+public:
+    // mutable_globals are the globals that are assigned or declared more than once (see Resolver::MutableGlobals)
+    Optimizer(Arena &arena, const std::unordered_set<Symbol> &mutable_globals);
+    Optimizer(const Optimizer &) = delete;
+    ~Optimizer();
+    // optimizes the statements of a resolved program
+    void Optimize(std::pmr::vector<Stmt *> &statements);
+    // marks the strings made by folding
+    void MarkRoots(GarbageCollector &gc) override;
+
+private:
+    Arena &arena;
+    const std::unordered_set<Symbol> &mutable_globals;
+    std::unordered_map<Symbol, Object> constants; // the globals whose value is known, once their declaration has been passed
+    std::vector<LoxString *> strings;            // the strings made by folding
+    int depth = 0;                                // the number of blocks and functions around the statement being optimized
+    Expr *expr_result = nullptr;                  // what the last visited expression is replaced by
+    Stmt *stmt_result = nullptr;                  // what the last visited statement is replaced by; nullptr to remove it
+
+    Expr *Optimize(Expr *expr);
+    Stmt *Optimize(Stmt *stmt);
+    Stmt *OptimizeBody(Stmt *stmt);                         // optimize a statement that cannot be removed
+    void OptimizeList(std::pmr::vector<Stmt *> &statements); // optimize a list of statements, removing those that do nothing
+    Literal *MakeLiteral(Object value);
+    // visitor methods
+    Object VisitAssignExpr(Assign &expr) override;
+    Object VisitBinaryExpr(Binary &expr) override;
+    Object VisitCallExpr(Call &expr) override;
+    Object VisitGetExpr(Get &expr) override;
+    Object VisitGroupingExpr(Grouping &expr) override;
+    Object VisitLiteralExpr(Literal &expr) override;
+    Object VisitLogicalExpr(Logical &expr) override;
+    Object VisitSetExpr(Set &expr) override;
+    Object VisitSuperExpr(Super &expr) override;
+    Object VisitThisExpr(This &expr) override;
+    Object VisitUnaryExpr(Unary &expr) override;
+    Object VisitVariableExpr(Variable &expr) override;
+
+    Object VisitBlockStmt(Block &stmt) override;
+    Object VisitClassStmt(Class &stmt) override;
+    Object VisitExpressionStmt(Expression &stmt) override;
+    Object VisitFunctionStmt(Function &stmt) override;
+    Object VisitIfStmt(If &stmt) override;
+    Object VisitPrintStmt(Print &stmt) override;
+    Object VisitReturnStmt(Return &stmt) override;
+    Object VisitVarStmt(Var &stmt) override;
+    Object VisitWhileStmt(While &stmt) override;
+};
+
+#endif // OPTIMIZER_H
@@ -13,23 +13,34 @@
  * classes, and control flow structures. Each construct is parsed by a separate method, and
  * these methods call each other recursively to parse nested constructs.
  *
+ * Advance pulls the next token from the Scanner into a ring buffer that holds the last few tokens, and
+ * Peek and Previous return references into it; a reference stays valid until the parser advances
+ * WINDOW_SIZE - 1 more tokens, so callers copy the tokens they keep. The value of a literal token is
+ * looked up in the Scanner's literal table by the token's start, which is sorted because tokens are
+ * scanned in order.
+ *
+ * Every node is created in the Arena passed to the constructor, which owns the tree: the nodes
+ * and their lists are freed together when the arena is released, not one by one.
+ *
  * The parser also includes error handling. If a syntax error is detected, an exception is
  * thrown and the parser attempts to synchronize with the next valid position in the source
  * code.
  */
+#include <algorithm>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 #include "parser.h"
 #include "error.h"
 
-Parser::Parser(std::vector<Token> tokens)
+Parser::Parser(Scanner &scanner, Arena &arena) : scanner(scanner), arena(arena)
 {
-    this->tokens = tokens;
+    window[0] = scanner.NextToken();
 }
 
-std::vector<Stmt *> Parser::Parse()
+std::pmr::vector<Stmt *> Parser::Parse()
 {
-    std::vector<Stmt *> statements;
+    std::pmr::vector<Stmt *> statements(arena.Resource());
     while (!IsAtEnd())
     {
         statements.push_back(Declaration());
@@ -72,7 +83,7 @@ Stmt *Parser::PrintStatement()
 {
     Expr *value = ExpressionFun();
     Consume(SEMICOLON, "Expect ';' after value.");
-    return new Print(value);
+    return arena.New<Print>(value);
 }
 Stmt *Parser::VarDeclaration()
 {
@@ -85,7 +96,7 @@ Stmt *Parser::VarDeclaration()
     }
 
     Consume(SEMICOLON, "Expect ';' after variable declaration.");
-    return new Var(name, initializer);
+    return arena.New<Var>(name, initializer);
 }
 Stmt *Parser::WhileStatement()
 {
@@ -94,19 +105,19 @@ Stmt *Parser::WhileStatement()
     Consume(RIGHT_PAREN, "Expect ')' after condition.");
     Stmt *body = Statement();
 
-    return new While(condition, body);
+    return arena.New<While>(condition, body);
 }
 Stmt *Parser::ExpressionStatement()
 {
     Expr *expr = ExpressionFun();
     Consume(SEMICOLON, "Expect ';' after expression.");
-    return new Expression(expr);
+    return arena.New<Expression>(expr);
 }
 Function *Parser::FunctionMethod(std::string kind)
 {
     Token name = Consume(IDENTIFIER, "Expect " + kind + " name.");
     Consume(LEFT_PAREN, "Expect '(' after " + kind + " name.");
-    std::vector<Token> parameters;
+    std::pmr::vector<Token> parameters(arena.Resource());
     if (!Check(RIGHT_PAREN))
     {
         do
@@ -121,12 +132,12 @@ Function *Parser::FunctionMethod(std::string kind)
     }
     Consume(RIGHT_PAREN, "Expect ')' after parameters.");
     Consume(LEFT_BRACE, "Expect '{' before " + kind + " body.");
-    std::vector<Stmt *> body = BlockFun();
-    return new Function(name, parameters, body);
+    std::pmr::vector<Stmt *> body = BlockFun();
+    return arena.New<Function>(name, std::move(parameters), std::move(body));
 }
-std::vector<Stmt *> Parser::BlockFun()
+std::pmr::vector<Stmt *> Parser::BlockFun()
 {
-    std::vector<Stmt *> statements;
+    std::pmr::vector<Stmt *> statements(arena.Resource());
 
     while (!Check(RIGHT_BRACE) && !IsAtEnd())
         statements.push_back(Declaration());
@@ -148,11 +159,11 @@ Expr *Parser::Assignment()
         if (auto variableExpr = dynamic_cast<Variable *>(expr))
         {
             Token name = variableExpr->name;
-            return new Assign(name, value);
+            return arena.New<Assign>(name, value);
         }
         else if (auto getExpr = dynamic_cast<Get *>(expr))
         {
-            return new Set(getExpr->object, getExpr->name, value);
+            return arena.New<Set>(getExpr->object, getExpr->name, value);
 
             Error(equals, "Invalid assignment target.");
         }
@@ -167,7 +178,7 @@ Expr *Parser::Or()
     {
         Token op = Previous();
         Expr *right = And();
-        expr = new Logical(expr, op, right);
+        expr = arena.New<Logical>(expr, op, right);
     }
 
     return expr;
@@ -180,7 +191,7 @@ Expr *Parser::And()
     {
         Token op = Previous();
         Expr *right = Equality();
-        expr = new Logical(expr, op, right);
+        expr = arena.New<Logical>(expr, op, right);
     }
 
     return expr;
@@ -198,7 +209,7 @@ Stmt *Parser::Statement()
     if (Match(WHILE))
         return WhileStatement();
     if (Match(LEFT_BRACE))
-        return new Block(BlockFun());
+        return arena.New<Block>(BlockFun());
 
     return ExpressionStatement();
 }
@@ -212,7 +223,7 @@ Stmt *Parser::ReturnStatement()
     }
 
     Consume(SEMICOLON, "Expect ';' after return value.");
-    return new Return(keyword, value);
+    return arena.New<Return>(keyword, value);
 }
 Stmt *Parser::ForStatement()
 {
@@ -246,20 +257,20 @@ Stmt *Parser::ForStatement()
     Stmt *body = Statement();
     if (increment != nullptr)
     {
-        std::vector<Stmt *> stmtVector;
+        std::pmr::vector<Stmt *> stmtVector(arena.Resource());
         stmtVector.push_back(body);
-        stmtVector.push_back(new Expression(increment));
-        body = new Block(stmtVector);
+        stmtVector.push_back(arena.New<Expression>(increment));
+        body = arena.New<Block>(std::move(stmtVector));
     }
     if (condition == nullptr)
-        condition = new Literal(true);
-    body = new While(condition, body);
+        condition = arena.New<Literal>(true);
+    body = arena.New<While>(condition, body);
     if (initializer != nullptr)
     {
-        std::vector<Stmt *> stmtVector;
+        std::pmr::vector<Stmt *> stmtVector(arena.Resource());
         stmtVector.push_back(initializer);
         stmtVector.push_back(body);
-        body = new Block(stmtVector);
+        body = arena.New<Block>(std::move(stmtVector));
     }
     return body;
 }
@@ -276,7 +287,7 @@ Stmt *Parser::IfStatement()
         elseBranch = Statement();
     }
 
-    return new If(condition, thenBranch, elseBranch);
+    return arena.New<If>(condition, thenBranch, elseBranch);
 }
 Stmt *Parser::Declaration()
 {
@@ -304,17 +315,17 @@ Stmt *Parser::ClassDeclaration()
     if (Match(LESS))
     {
         Consume(IDENTIFIER, "Expect superclass name.");
-        superclass = new Variable(Previous());
+        superclass = arena.New<Variable>(Previous());
     }
     Consume(LEFT_BRACE, "Expect '{' before class body.");
-    std::vector<Function *> methods;
+    std::pmr::vector<Function *> methods(arena.Resource());
     while (!Check(RIGHT_BRACE) && !IsAtEnd())
     {
         methods.push_back(FunctionMethod("method"));
     }
     Consume(RIGHT_BRACE, "Expect '}' after class body.");
 
-    return new Class(name, superclass, methods);
+    return arena.New<Class>(name, superclass, std::move(methods));
 }
 Expr *Parser::Equality()
 {
@@ -324,7 +335,7 @@ Expr *Parser::Equality()
     {
         Token op = Previous();
         Expr *right = Comparison();
-        expr = new Binary(expr, op, right);
+        expr = arena.New<Binary>(expr, op, right);
     }
 
     return expr;
@@ -338,7 +349,7 @@ Expr *Parser::Comparison()
     {
         Token op = Previous();
         Expr *right = Term();
-        expr = new Binary(expr, op, right);
+        expr = arena.New<Binary>(expr, op, right);
     }
 
     return expr;
@@ -352,7 +363,7 @@ Expr *Parser::Term()
     {
         Token op = Previous();
         Expr *right = Factor();
-        expr = new Binary(expr, op, right);
+        expr = arena.New<Binary>(expr, op, right);
     }
 
     return expr;
@@ -366,7 +377,7 @@ Expr *Parser::Factor()
     {
         Token op = Previous();
         Expr *right = UnaryFun();
-        expr = new Binary(expr, op, right);
+        expr = arena.New<Binary>(expr, op, right);
     }
 
     return expr;
@@ -378,14 +389,14 @@ Expr *Parser::UnaryFun()
     {
         Token op = Previous();
         Expr *right = UnaryFun();
-        return new Unary(op, right);
+        return arena.New<Unary>(op, right);
     }
 
     return CallFun();
 }
 Expr *Parser::FinishCall(Expr *callee)
 {
-    std::vector<Expr *> arguments;
+    std::pmr::vector<Expr *> arguments(arena.Resource());
     if (!Check(RIGHT_PAREN))
     {
         do
@@ -400,7 +411,7 @@ Expr *Parser::FinishCall(Expr *callee)
 
     Token paren = Consume(RIGHT_PAREN, "Expect ')' after arguments.");
 
-    return new Call(callee, paren, arguments);
+    return arena.New<Call>(callee, paren, std::move(arguments));
 }
 Expr *Parser::CallFun()
 {
@@ -415,7 +426,7 @@ Expr *Parser::CallFun()
         else if (Match(DOT))
         {
             Token name = Consume(IDENTIFIER, "Expect property name after '.'.");
-            expr = new Get(expr, name);
+            expr = arena.New<Get>(expr, name);
         }
         else
         {
@@ -428,30 +439,30 @@ Expr *Parser::CallFun()
 Expr *Parser::Primary()
 {
     if (Match(FALSE))
-        return new Literal(false);
+        return arena.New<Literal>(false);
     if (Match(TRUE))
-        return new Literal(true);
+        return arena.New<Literal>(true);
     if (Match(NIL))
-        return new Literal(nullptr);
+        return arena.New<Literal>(nullptr);
     if (Match(NUMBER, STRING))
-        return new Literal(Previous().literal);
+        return arena.New<Literal>(LiteralOf(Previous()));
     if (Match(SUPER))
     {
         Token keyword = Previous();
         Consume(DOT, "Expect '.' after 'super'.");
         Token method = Consume(IDENTIFIER,
                                "Expect superclass method name.");
-        return new Super(keyword, method);
+        return arena.New<Super>(keyword, method);
     }
     if (Match(THIS))
-        return new This(Previous());
+        return arena.New<This>(Previous());
     if (Match(IDENTIFIER))
-        return new Variable(Previous());
+        return arena.New<Variable>(Previous());
     if (Match(LEFT_PAREN))
     {
         Expr *expr = ExpressionFun();
         Consume(RIGHT_PAREN, "Expect ')' after expression.");
-        return new Grouping(expr);
+        return arena.New<Grouping>(expr);
     }
     throw Error(Peek(), "Expect expression.");
 }
@@ -470,14 +481,14 @@ bool Parser::Match(Args... types)
     }
     return false;
 }
-Token Parser::Consume(TokenType type, std::string message)
+const Token &Parser::Consume(TokenType type, std::string message)
 {
     if (Check(type))
         return Advance();
 
     throw Error(Peek(), message);
 }
-Parser::ParseError Parser::Error(Token token, std::string message)
+Parser::ParseError Parser::Error(const Token &token, std::string message)
 {
     Error::ReportError(token, message);
     return ParseError();
@@ -488,23 +499,32 @@ bool Parser::Check(TokenType type)
         return false;
     return Peek().type == type;
 }
-Token Parser::Advance()
+const Token &Parser::Advance()
 {
     if (!IsAtEnd())
+    {
         current++;
+        window[current % WINDOW_SIZE] = scanner.NextToken();
+    }
     return Previous();
 }
 bool Parser::IsAtEnd()
 {
     return Peek().type == END_OF_FILE;
 }
-Token Parser::Peek()
+const Token &Parser::Peek()
+{
+    return window[current % WINDOW_SIZE];
+}
+const Token &Parser::Previous()
 {
-    if (static_cast<size_t>(current) >= tokens.size())
-        return Token(END_OF_FILE, "", nullptr, tokens[current - 1].line);
-    return tokens[current];
+    return window[(current - 1) % WINDOW_SIZE];
 }
-Token Parser::Previous()
+Object Parser::LiteralOf(const Token &token)
 {
-    return tokens[current - 1];
+    const std::vector<TokenLiteral> &literals = scanner.Literals();
+    auto it = std::lower_bound(literals.begin(), literals.end(), token.start,
+                               [](const TokenLiteral &literal, uint32_t start)
+                               { return literal.start < start; });
+    return it->value;
 }
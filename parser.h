@@ -3,6 +3,9 @@
  * This file defines the Parser class, which is used to parse the source code and generate an abstract syntax tree (AST).
  * The Parser class includes methods for parsing different types of statements and expressions, and for handling errors during parsing.
  * The Parser class also includes a nested ParseError class, which represents an error that occurred during parsing.
+ * The nodes of the tree, and their lists, are allocated in the Arena the Parser is given, which must outlive the tree.
+ * The Parser pulls tokens from the Scanner one at a time as it needs them. It only keeps the current and previous tokens, in a small
+ * ring buffer, so the tokens of the whole file never exist at once and parsing starts before the end of the file has been scanned.
  */
 #ifndef PARSER_H
 #define PARSER_H
@@ -11,19 +14,25 @@
 #include <memory>
 #include "token.h"
 #include "expr.h"
+#include "arena.h"
+#include "scanner.h"
 
 class Parser
 {
 public:
-    Parser(std::vector<Token> tokens);
-    std::vector<Stmt *> Parse();
+    Parser(Scanner &scanner, Arena &arena);
+    std::pmr::vector<Stmt *> Parse();
     class ParseError
     {
     };
 
 private:
-    int current = 0;
-    std::vector<Token> tokens;
+    static const int WINDOW_SIZE = 4; // a power of two; the previous and current tokens are the ones used
+
+    int current = 0;           // the index of the current token in the file
+    Scanner &scanner;          // the source of the tokens
+    Token window[WINDOW_SIZE]; // the last tokens pulled, by index modulo WINDOW_SIZE
+    Arena &arena;              // owns every node the parser creates
 
     void Synchronize(); // if error, skip to the next statement
     Expr *ExpressionFun();
@@ -32,7 +41,7 @@ private:
     Stmt *WhileStatement();
     Stmt *ExpressionStatement();
     Function *FunctionMethod(std::string kind);
-    std::vector<Stmt *> BlockFun();
+    std::pmr::vector<Stmt *> BlockFun();
     Expr *Assignment();
     Expr *Or();
     Expr *And();
@@ -54,13 +63,14 @@ private:
     template <typename... Args>
     bool Match(Args... types);
 
-    Token Consume(TokenType type, std::string message); // if not match, throw error
-    ParseError Error(Token token, std::string message);
+    const Token &Consume(TokenType type, std::string message); // if not match, throw error
+    ParseError Error(const Token &token, std::string message);
     bool Check(TokenType type);
-    Token Advance();
+    const Token &Advance();
     bool IsAtEnd();
-    Token Peek();     // return the current token
-    Token Previous(); // return the previous token
+    const Token &Peek();     // return the current token
+    const Token &Previous(); // return the previous token
+    Object LiteralOf(const Token &token); // the value of a NUMBER or STRING token
 };
 
 #endif // PARSER_H
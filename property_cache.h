@@ -0,0 +1,59 @@
+/*
+ * property_cache.h
+ * This file defines the PropertyCache class, the inline cache of one property access site (a Get or Set expression).
+ *
+ * An entry remembers, for one receiver shape, what the site resolved to: the slot of a field, the method found on the class, or for
+ * a Set that added a field, the shape the instance moved to. A shape identifies the class of its instances, so the method and the
+ * next shape are the same for every receiver with that shape.
+ *
+ * The cache starts empty, becomes monomorphic after the first lookup, and grows up to MAX_ENTRIES shapes. After that the site is
+ * megamorphic and further misses take the slow path without being cached.
+ *
+ * Entries are keyed by the shape's id rather than its address. Ids are never reused, so an entry for a shape whose class has been
+ * collected can never match a new shape allocated at the same address. Shapes and the methods of a class never change once created,
+ * so no other invalidation is needed.
+ */
+#ifndef PROPERTY_CACHE_H
+#define PROPERTY_CACHE_H
+
+#include <cstdint>
+
+class Shape;
+class LoxFunction;
+
+class PropertyCache
+{
+public:
+    struct Entry
+    {
+        uint64_t shape_id;
+        int slot;            // the field's slot, or -1 for a method
+        LoxFunction *method; // the method a Get resolved to
+        Shape *next_shape;   // the shape a Set moved the instance to when it added the field, or nullptr
+    };
+
+    // returns the entry for a shape, or nullptr on a miss
+    const Entry *Find(uint64_t shape_id) const
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (entries[i].shape_id == shape_id)
+                return &entries[i];
+        }
+        return nullptr;
+    }
+    // remembers what the site resolved to for a shape, unless the cache is full
+    void Add(const Entry &entry)
+    {
+        if (count < MAX_ENTRIES)
+            entries[count++] = entry;
+    }
+
+private:
+    static const int MAX_ENTRIES = 4;
+
+    Entry entries[MAX_ENTRIES];
+    int count = 0;
+};
+
+#endif // PROPERTY_CACHE_H
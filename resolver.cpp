@@ -4,17 +4,25 @@
  * The Resolver class is used to resolve and handle the scope of variables and functions in the source code.
  * The Resolver class is a subclass of the Interpreter class, and it overrides the visit methods for each type of statement and expression.
  * The Resolver class includes methods for beginning and ending a scope, declaring and defining a variable, and resolving a local variable.
+ * VisitBlockStmt records how many locals a block declares, so that the interpreter can run a block that declares none as it would run
+ * its statements.
+ * Declare and VisitAssignExpr record the globals that are declared twice or assigned, for MutableGlobals.
+ *
+ * Declare gives a local the next slot of the function being resolved, and EndScope gives back the slots of the scope it ends.
+ * ResolveLocal finds the scope that declares a name and the function that scope belongs to. If it is not the function being resolved,
+ * ResolveUpvalue captures the slot in the function just inside its owner, and each function further in captures the upvalue of the
+ * one around it; AddUpvalue reuses the capture when a function uses the same variable twice.
  */
 #include "resolver.h"
 #include "error.h"
 #include "lox_instance.h"
 #include "interpreter.h"
 
-Resolver::Resolver(Interpreter *interpreter)
+Resolver::Resolver()
 {
-    this->interpreter = interpreter;
+    functions.push_back(FunctionScope{0, 0, nullptr});
 }
-void Resolver::Resolve(std::vector<Stmt *> statements)
+void Resolver::Resolve(const std::pmr::vector<Stmt *> &statements)
 {
     for (Stmt *statement : statements)
     {
@@ -25,6 +33,7 @@ Object Resolver::VisitBlockStmt(Block &stmt)
 {
     BeginScope();
     Resolve(stmt.statements);
+    stmt.locals = static_cast<int>(scopes.back().size());
     EndScope();
     return nullptr;
 }
@@ -34,7 +43,7 @@ Object Resolver::VisitClassStmt(Class &stmt)
     currentClass = ClassType::CLASS;
     Declare(stmt.name);
     Define(stmt.name);
-    if (stmt.superclass != nullptr && stmt.name.lexeme == stmt.superclass->name.lexeme)
+    if (stmt.superclass != nullptr && stmt.name.symbol == stmt.superclass->name.symbol)
     {
         Error::ReportError(stmt.superclass->name, "A class can't inherit from itself.");
     }
@@ -46,21 +55,18 @@ Object Resolver::VisitClassStmt(Class &stmt)
     if (stmt.superclass != nullptr)
     {
         BeginScope();
-        scopes.top()["super"] = true;
+        scopes.back()[SymbolTable::SUPER] = LocalVariable{true, functions.back().locals++};
     }
-    BeginScope();
-    scopes.top()["this"] = true;
     for (Function *method : stmt.methods)
     {
         FunctionType declaration = FunctionType::METHOD;
-        if (method->name.lexeme.compare("init") == 0)
+        if (method->name.symbol == SymbolTable::INIT)
         {
             declaration = FunctionType::INITIALIZER;
         }
 
         ResolveFunction(method, declaration);
     }
-    EndScope();
     if (stmt.superclass != nullptr)
         EndScope();
     currentClass = enclosingClass;
@@ -129,7 +135,9 @@ Object Resolver::VisitWhileStmt(While &stmt)
 Object Resolver::VisitAssignExpr(Assign &expr)
 {
     Resolve(expr.value);
-    ResolveLocal(&expr, expr.name);
+    ResolveLocal(expr.name.symbol, expr.binding);
+    if (expr.binding.kind == Binding::GLOBAL)
+        mutable_globals.insert(expr.name.symbol);
     return nullptr;
 }
 Object Resolver::VisitBinaryExpr(Binary &expr)
@@ -188,7 +196,8 @@ Object Resolver::VisitSuperExpr(Super &expr)
         Error::ReportError(expr.keyword,
                            "Can't use 'super' in a class with no superclass.");
     }
-    ResolveLocal(&expr, expr.keyword);
+    ResolveLocal(SymbolTable::SUPER, expr.binding);
+    ResolveLocal(SymbolTable::THIS, expr.this_binding);
     return nullptr;
 }
 Object Resolver::VisitThisExpr(This &expr)
@@ -198,7 +207,7 @@ Object Resolver::VisitThisExpr(This &expr)
         Error::ReportError(expr.keyword, "Can't use 'this' outside of a class.");
         return nullptr;
     }
-    ResolveLocal(&expr, expr.keyword);
+    ResolveLocal(SymbolTable::THIS, expr.binding);
     return nullptr;
 }
 Object Resolver::VisitUnaryExpr(Unary &expr)
@@ -208,12 +217,14 @@ Object Resolver::VisitUnaryExpr(Unary &expr)
 }
 Object Resolver::VisitVariableExpr(Variable &expr)
 {
-    if (!scopes.empty() && !scopes.top().empty() && scopes.top().find(expr.name.lexeme) != scopes.top().end() && scopes.top().find(expr.name.lexeme)->second == false)
+    if (!scopes.empty())
     {
-        Error::ReportError(expr.name, "Can't read local variable in its own initializer.");
+        auto it = scopes.back().find(expr.name.symbol);
+        if (it != scopes.back().end() && it->second.defined == false)
+            Error::ReportError(expr.name, "Can't read local variable in its own initializer.");
     }
 
-    ResolveLocal(&expr, expr.name);
+    ResolveLocal(expr.name.symbol, expr.binding);
     return nullptr;
 }
 
@@ -231,7 +242,10 @@ void Resolver::ResolveFunction(Function *function, FunctionType type)
     FunctionType enclosingFunction = currentFunction;
     currentFunction = type;
 
+    functions.push_back(FunctionScope{scopes.size(), 0, function});
     BeginScope();
+    if (type == FunctionType::METHOD || type == FunctionType::INITIALIZER)
+        scopes.back()[SymbolTable::THIS] = LocalVariable{true, functions.back().locals++}; // "this" is slot 0 of a method's frame, before the parameters
     for (Token param : function->params)
     {
         Declare(param);
@@ -240,54 +254,80 @@ void Resolver::ResolveFunction(Function *function, FunctionType type)
 
     Resolve(function->body);
     EndScope();
+    functions.pop_back();
     currentFunction = enclosingFunction;
 }
 void Resolver::BeginScope()
 {
-    std::map<std::string, bool> newScope;
-    scopes.push(newScope);
+    scopes.emplace_back();
 }
 void Resolver::EndScope()
 {
-    scopes.pop();
+    functions.back().locals -= static_cast<int>(scopes.back().size());
+    scopes.pop_back();
 }
 void Resolver::Declare(const Token &name)
 {
     if (scopes.empty())
+    {
+        if (!declared_globals.insert(name.symbol).second)
+            mutable_globals.insert(name.symbol);
         return;
+    }
 
-    std::map<std::string, bool> &scope = scopes.top();
-    auto ret = scope.find(name.lexeme);
+    std::map<Symbol, LocalVariable> &scope = scopes.back();
+    auto ret = scope.find(name.symbol);
 
     if (ret != scope.end())
+    {
         Error::ReportError(name, "Already variable with this name in this scope.");
+        ret->second.defined = false;
+        return;
+    }
 
-    scope[name.lexeme] = false;
+    // the interpreter pushes locals in declaration order, so the next slot is the number of locals of the function in scope
+    scope[name.symbol] = LocalVariable{false, functions.back().locals++};
 }
 void Resolver::Define(Token &name)
 {
     if (scopes.empty())
         return;
 
-    scopes.top()[name.lexeme] = true;
+    scopes.back()[name.symbol].defined = true;
 }
-void Resolver::ResolveLocal(Expr *expr, const Token &name)
+void Resolver::ResolveLocal(Symbol name, Binding &binding)
 {
-    std::stack<std::map<std::string, bool>> temp;
-    temp = scopes;
-    for (int i = temp.size() - 1; i >= 0; i--)
+    for (int i = static_cast<int>(scopes.size()) - 1; i >= 0; i--)
     {
-        const std::map<std::string, bool> &currentScope = scopes.top();
-
-        auto it = currentScope.find(name.lexeme);
-
-        if (it != currentScope.end())
+        auto it = scopes[i].find(name);
+        if (it != scopes[i].end())
         {
-            interpreter->Resolve(expr, temp.size() - 1 - i);
-            scopes = temp;
+            size_t function = functions.size() - 1;
+            size_t owner = function;
+            while (functions[owner].first_scope > static_cast<size_t>(i))
+                owner--;
+            if (owner == function)
+                binding = Binding{Binding::LOCAL, it->second.slot};
+            else
+                binding = Binding{Binding::UPVALUE, ResolveUpvalue(function, owner, it->second.slot)};
             return;
         }
-        scopes.pop();
     }
-    scopes = temp;
+}
+int Resolver::ResolveUpvalue(size_t function, size_t owner, int slot)
+{
+    if (function - 1 == owner)
+        return AddUpvalue(functions[function].declaration, true, slot);
+    return AddUpvalue(functions[function].declaration, false, ResolveUpvalue(function - 1, owner, slot));
+}
+int Resolver::AddUpvalue(Function *function, bool is_local, int index)
+{
+    std::pmr::vector<Capture> &upvalues = function->upvalues;
+    for (size_t i = 0; i < upvalues.size(); i++)
+    {
+        if (upvalues[i].is_local == is_local && upvalues[i].index == index)
+            return static_cast<int>(i);
+    }
+    upvalues.push_back(Capture{is_local, index});
+    return static_cast<int>(upvalues.size()) - 1;
 }
@@ -3,12 +3,22 @@
  * This file defines the Resolver class, which is used to resolve and handle the scope of variables and functions in the source code.
  * The Resolver class is a subclass of the Interpreter class, and it overrides the visit methods for each type of statement and expression.
  * The Resolver class includes methods for beginning and ending a scope, declaring and defining a variable, and resolving a local variable.
+ * Every local is numbered with a slot in the frame of the function that declares it: the locals of a function's nested blocks follow its
+ * parameters, and a block's slots are reused once it ends. Each variable reference is annotated with its Binding: a local of the
+ * function it appears in, an upvalue when it belongs to an enclosing function, or a global. A reference to a local of an enclosing
+ * function adds it to the upvalues of every function in between, so that each closure can capture it from the one around it; those
+ * locals are the captured ones, and every other local stays in its slot.
+ * The top level is resolved like the body of a function, whose locals are those of its blocks.
+ * MutableGlobals returns the globals that are assigned somewhere or declared more than once; every other global keeps the value of its
+ * only declaration once it has run, which the Optimizer relies on.
  */
 #ifndef RESOLVER_H
 #define RESOLVER_H
 
-#include <stack>
+#include <vector>
 #include <map>
+#include <unordered_set>
+#include "symbol_table.h"
 #include "expr.h"
 #include "interpreter.h"
 #include "error.h"
@@ -16,8 +26,10 @@
 class Resolver : public Interpreter
 {
 public:
-    Resolver(Interpreter *interpreter);
-    void Resolve(std::vector<Stmt *> statements);
+    Resolver();
+    void Resolve(const std::pmr::vector<Stmt *> &statements);
+    // the globals that are assigned or declared more than once
+    const std::unordered_set<Symbol> &MutableGlobals() const { return mutable_globals; }
 
 private:
     enum FunctionType
@@ -36,10 +48,25 @@ private:
 
     ClassType currentClass = ClassType::NONE_CLASS;
     FunctionType currentFunction = FunctionType::NONE;
-    Interpreter *interpreter;
-    // A stack of scopes, where each scope is a map from variable names to a boolean value.
-    // The boolean value indicates whether the variable has been initialized.
-    std::stack<std::map<std::string, bool>> scopes;
+    // A local variable: whether it has been initialized, and its slot in the environment of its scope.
+    struct LocalVariable
+    {
+        bool defined;
+        int slot;
+    };
+    // A stack of scopes, where each scope is a map from the symbols of variable names to their local variable.
+    std::vector<std::map<Symbol, LocalVariable>> scopes;
+    // A function being resolved: the index of its outermost scope, the number of its locals in scope, and its declaration.
+    struct FunctionScope
+    {
+        size_t first_scope;
+        int locals;
+        Function *declaration; // nullptr for the top level
+    };
+    // A stack of the functions being resolved, starting with the top level.
+    std::vector<FunctionScope> functions;
+    std::unordered_set<Symbol> declared_globals; // the globals declared so far
+    std::unordered_set<Symbol> mutable_globals;  // the globals assigned or declared more than once
     // visitor methods
     Object VisitBlockStmt(Block &stmt) override;
     Object VisitClassStmt(Class &stmt) override;
@@ -71,6 +98,10 @@ private:
     void EndScope();                                  // pop the current scope off the stack
     void Declare(const Token &name);                  // declare a variable in the current scope
     void Define(Token &name);                         // mark a variable as initialized in the current scope
-    void ResolveLocal(Expr *expr, const Token &name); // resolve a local variable
+    void ResolveLocal(Symbol name, Binding &binding); // find the binding of a variable, leaving it global if no scope declares it
+    // the index of the upvalue through which the function at index function reaches the slot of the function at index owner
+    int ResolveUpvalue(size_t function, size_t owner, int slot);
+    // add a capture to a function, unless it has it already, and return its index
+    int AddUpvalue(Function *function, bool is_local, int index);
 };
 #endif // RESOLVER_H
\ No newline at end of file
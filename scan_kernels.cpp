@@ -0,0 +1,245 @@
+/*
+ * scan_kernels.cpp
+ * This file implements the kernels declared in scan_kernels.h.
+ *
+ * The scalar kernels test one byte at a time. The vector kernels compare a whole block of bytes with the characters they look for,
+ * turn the result into a bit mask with movemask, and return at the lowest set bit; a newline count is the population count of the
+ * newline mask below that bit. Fewer than a block of bytes before end are left to the scalar kernel, so no load reads past the source.
+ *
+ * The character classes only use signed byte comparisons, which treat bytes of 0x80 and above as negative: they are never whitespace,
+ * identifier characters or digits, which matches the scalar kernels.
+ *
+ * The AVX2 kernels are compiled with the avx2 target attribute, so the file builds without -mavx2, and Instance only selects them
+ * after __builtin_cpu_supports reports AVX2. SSE2 is part of x86-64, so the SSE2 kernels need no check; other processors use the
+ * scalar kernels.
+ */
+#include "scan_kernels.h"
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define SCAN_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+static bool IsWhitespace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+static bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+static bool IsIdentifier(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || IsDigit(c); }
+
+static const char *ScalarSkipWhitespace(const char *p, const char *end, unsigned &lines)
+{
+    for (; p < end && IsWhitespace(*p); p++)
+        lines += *p == '\n';
+    return p;
+}
+static const char *ScalarFindLineEnd(const char *p, const char *end)
+{
+    while (p < end && *p != '\n')
+        p++;
+    return p;
+}
+static const char *ScalarFindQuote(const char *p, const char *end, unsigned &lines)
+{
+    for (; p < end && *p != '"'; p++)
+        lines += *p == '\n';
+    return p;
+}
+static const char *ScalarSkipIdentifier(const char *p, const char *end)
+{
+    while (p < end && IsIdentifier(*p))
+        p++;
+    return p;
+}
+static const char *ScalarSkipDigits(const char *p, const char *end)
+{
+    while (p < end && IsDigit(*p))
+        p++;
+    return p;
+}
+
+#ifdef SCAN_KERNELS_X86
+// the bits below the lowest set bit of mask
+static unsigned BitsBelow(unsigned mask) { return (mask & -mask) - 1; }
+
+static __m128i InRange(__m128i bytes, char low, char high)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8(low - 1)), _mm_cmplt_epi8(bytes, _mm_set1_epi8(high + 1)));
+}
+static __m128i WhitespaceBytes(__m128i bytes)
+{
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))),
+                        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))));
+}
+static __m128i IdentifierBytes(__m128i bytes)
+{
+    __m128i letters = InRange(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), 'a', 'z');
+    return _mm_or_si128(_mm_or_si128(letters, InRange(bytes, '0', '9')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_')));
+}
+
+static const char *Sse2SkipWhitespace(const char *p, const char *end, unsigned &lines)
+{
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        unsigned stop = ~_mm_movemask_epi8(WhitespaceBytes(bytes)) & 0xffff;
+        unsigned newlines = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+        if (stop != 0)
+        {
+            lines += __builtin_popcount(newlines & BitsBelow(stop));
+            return p + __builtin_ctz(stop);
+        }
+        lines += __builtin_popcount(newlines);
+    }
+    return ScalarSkipWhitespace(p, end, lines);
+}
+static const char *Sse2FindLineEnd(const char *p, const char *end)
+{
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        unsigned stop = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+        if (stop != 0)
+            return p + __builtin_ctz(stop);
+    }
+    return ScalarFindLineEnd(p, end);
+}
+static const char *Sse2FindQuote(const char *p, const char *end, unsigned &lines)
+{
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        unsigned stop = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')));
+        unsigned newlines = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+        if (stop != 0)
+        {
+            lines += __builtin_popcount(newlines & BitsBelow(stop));
+            return p + __builtin_ctz(stop);
+        }
+        lines += __builtin_popcount(newlines);
+    }
+    return ScalarFindQuote(p, end, lines);
+}
+static const char *Sse2SkipIdentifier(const char *p, const char *end)
+{
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        unsigned stop = ~_mm_movemask_epi8(IdentifierBytes(bytes)) & 0xffff;
+        if (stop != 0)
+            return p + __builtin_ctz(stop);
+    }
+    return ScalarSkipIdentifier(p, end);
+}
+static const char *Sse2SkipDigits(const char *p, const char *end)
+{
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        unsigned stop = ~_mm_movemask_epi8(InRange(bytes, '0', '9')) & 0xffff;
+        if (stop != 0)
+            return p + __builtin_ctz(stop);
+    }
+    return ScalarSkipDigits(p, end);
+}
+
+#define AVX2 __attribute__((target("avx2")))
+
+static AVX2 __m256i InRange256(__m256i bytes, char low, char high)
+{
+    return _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8(low - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), bytes));
+}
+static AVX2 __m256i WhitespaceBytes256(__m256i bytes)
+{
+    return _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\t')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r'))));
+}
+static AVX2 __m256i IdentifierBytes256(__m256i bytes)
+{
+    __m256i letters = InRange256(_mm256_or_si256(bytes, _mm256_set1_epi8(0x20)), 'a', 'z');
+    return _mm256_or_si256(_mm256_or_si256(letters, InRange256(bytes, '0', '9')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_')));
+}
+
+static AVX2 const char *Avx2SkipWhitespace(const char *p, const char *end, unsigned &lines)
+{
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(WhitespaceBytes256(bytes)));
+        unsigned newlines = _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')));
+        if (stop != 0)
+        {
+            lines += __builtin_popcount(newlines & BitsBelow(stop));
+            return p + __builtin_ctz(stop);
+        }
+        lines += __builtin_popcount(newlines);
+    }
+    return Sse2SkipWhitespace(p, end, lines);
+}
+static AVX2 const char *Avx2FindLineEnd(const char *p, const char *end)
+{
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        unsigned stop = _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')));
+        if (stop != 0)
+            return p + __builtin_ctz(stop);
+    }
+    return Sse2FindLineEnd(p, end);
+}
+static AVX2 const char *Avx2FindQuote(const char *p, const char *end, unsigned &lines)
+{
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        unsigned stop = _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"')));
+        unsigned newlines = _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')));
+        if (stop != 0)
+        {
+            lines += __builtin_popcount(newlines & BitsBelow(stop));
+            return p + __builtin_ctz(stop);
+        }
+        lines += __builtin_popcount(newlines);
+    }
+    return Sse2FindQuote(p, end, lines);
+}
+static AVX2 const char *Avx2SkipIdentifier(const char *p, const char *end)
+{
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(IdentifierBytes256(bytes)));
+        if (stop != 0)
+            return p + __builtin_ctz(stop);
+    }
+    return Sse2SkipIdentifier(p, end);
+}
+static AVX2 const char *Avx2SkipDigits(const char *p, const char *end)
+{
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(InRange256(bytes, '0', '9')));
+        if (stop != 0)
+            return p + __builtin_ctz(stop);
+    }
+    return Sse2SkipDigits(p, end);
+}
+
+#undef AVX2
+#endif // SCAN_KERNELS_X86
+
+static ScanKernels SelectKernels()
+{
+#ifdef SCAN_KERNELS_X86
+    if (__builtin_cpu_supports("avx2"))
+        return ScanKernels{Avx2SkipWhitespace, Avx2FindLineEnd, Avx2FindQuote, Avx2SkipIdentifier, Avx2SkipDigits, "avx2"};
+    return ScanKernels{Sse2SkipWhitespace, Sse2FindLineEnd, Sse2FindQuote, Sse2SkipIdentifier, Sse2SkipDigits, "sse2"};
+#else
+    return ScanKernels{ScalarSkipWhitespace, ScalarFindLineEnd, ScalarFindQuote, ScalarSkipIdentifier, ScalarSkipDigits, "scalar"};
+#endif
+}
+
+const ScanKernels &ScanKernels::Instance()
+{
+    static const ScanKernels kernels = SelectKernels();
+    return kernels;
+}
@@ -0,0 +1,31 @@
+/*
+ * scan_kernels.h
+ * This file defines the ScanKernels class, the loops the Scanner uses to get over runs of characters many bytes at a time.
+ *
+ * Each kernel starts at a pointer into the source and returns a pointer to the first character that ends the run, or end:
+ * SkipWhitespace skips spaces, tabs, carriage returns and newlines, FindLineEnd finds the newline that ends a comment, FindQuote finds
+ * the quote that closes a string, and SkipIdentifier and SkipDigits skip identifier characters and digits. SkipWhitespace and FindQuote
+ * add the newlines they pass to lines.
+ *
+ * There are three implementations of the kernels: AVX2 (32 bytes at a time), SSE2 (16 bytes at a time) and plain loops over single
+ * bytes, which also finish the last bytes of the vector versions. Instance picks the best one the processor supports the first time
+ * it is called; name tells which one it picked.
+ */
+#ifndef SCAN_KERNELS_H
+#define SCAN_KERNELS_H
+
+class ScanKernels
+{
+public:
+    // the kernels for the processor the program runs on
+    static const ScanKernels &Instance();
+
+    const char *(*SkipWhitespace)(const char *p, const char *end, unsigned &lines);
+    const char *(*FindLineEnd)(const char *p, const char *end);
+    const char *(*FindQuote)(const char *p, const char *end, unsigned &lines);
+    const char *(*SkipIdentifier)(const char *p, const char *end);
+    const char *(*SkipDigits)(const char *p, const char *end);
+    const char *name; // "avx2", "sse2" or "scalar"
+};
+
+#endif // SCAN_KERNELS_H
@@ -3,26 +3,224 @@
  * This file implements the Scanner class defined in scanner.h.
  * The Scanner class is used to scan the source code and generate a list of tokens.
  * It includes methods for scanning individual tokens, checking the next character in the source code, and checking if the end of the source code has been reached.
+ * The NextToken method runs ScanToken until a lexeme produces a token, skipping whitespace and comments.
+ * The AddToken methods record the position of the lexeme, and the value of a literal in the side table.
+ * Runs of whitespace, comments, strings, identifiers and digits are skipped with the vectorised kernels of scan_kernels.h;
+ * the single characters in between still go through Advance and Peek.
+ * The Identifier method recognises keywords with the compile-time perfect hash of keywords.h, and interns names in the SymbolTable.
+ * The String method interns the literal's characters; the side table keeps the string alive, since MarkRoots marks it.
+ *
+ * ScanInParallel cuts the source just after line breaks, about evenly, and runs ScanChunk for each chunk on its own thread.
+ * A chunk Scanner sees the source only up to the end of its chunk, so its offsets are those of the whole source; it counts lines
+ * from 1, numbers its names and strings in tables of its own, and keeps its errors with the index of the token they came before.
+ * Only a string literal can continue past a line break, so a chunk is scanned correctly unless the chunk before it ended in an
+ * unterminated string. Stitch then scans it again, from that string's opening quote, and drops the error the string caused.
+ * Interning happens in Stitch, on the calling thread and in source order, because the SymbolTable, the StringTable and the
+ * garbage collector are not thread-safe, and so that the symbols are numbered as scanning on demand would number them.
+ * A chunk numbers its distinct names and strings itself, so only those are interned there; the tokens and literals themselves
+ * are renumbered and copied into place on the threads again.
  */
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <thread>
 #include "scanner.h"
+#include "keywords.h"
 #include "token_type_functions.h"
 #include "error.h"
+#include "lox_string.h"
+#include "string_table.h"
 
-Scanner::Scanner(std::string source) : source(source) {}
+Scanner::Scanner(std::string_view source) : source(source), kernels(ScanKernels::Instance())
+{
+    Token::SetSource(source);
+    GarbageCollector::Instance().AddRootSource(this);
+}
+Scanner::Scanner(std::string_view source, unsigned begin, unsigned line)
+    : source(source), kernels(ScanKernels::Instance()), current(begin), line(line), is_chunk(true) {}
+Scanner::~Scanner()
+{
+    if (!is_chunk)
+        GarbageCollector::Instance().RemoveRootSource(this);
+}
+void Scanner::MarkRoots(GarbageCollector &gc)
+{
+    for (const TokenLiteral &literal : literals)
+        gc.MarkValue(literal.value);
+}
 
-std::vector<Token> Scanner::ScanTokens()
+Token Scanner::NextToken()
 {
+    if (scanned_ahead)
+    {
+        // report the errors that came before the token, when scanning on demand would have
+        for (; next_error < errors.size() && errors[next_error].token_index <= next_scanned; next_error++)
+            Error::ReportError(errors[next_error].line, errors[next_error].message);
+        if (next_scanned + 1 < scanned.size())
+            return scanned[next_scanned++];
+        return scanned.back();
+    }
+
     while (!IsAtEnd())
     {
         // We are at the beginning of the next lexeme.
         start = current;
+        has_token = false;
         ScanToken();
+        if (has_token)
+            return token;
     }
 
+    return Token(END_OF_FILE, current, 0, line);
+}
+
+std::vector<Token> Scanner::ScanTokens()
+{
+    std::vector<Token> tokens;
+    do
+    {
+        tokens.push_back(NextToken());
+    } while (tokens.back().type != END_OF_FILE);
+
     return tokens;
 }
 
+// runs task(0) to task(count - 1), each on its own thread but the first, which runs on the calling thread
+static void RunInParallel(size_t count, const std::function<void(size_t)> &task)
+{
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < count; i++)
+        pool.emplace_back(task, i);
+    if (count > 0)
+        task(0);
+    for (std::thread &thread : pool)
+        thread.join();
+}
+
+void Scanner::ScanInParallel(unsigned threads)
+{
+    unsigned size = static_cast<unsigned>(source.length());
+    threads = std::max(1u, std::min(threads, size / MIN_CHUNK_SIZE));
+
+    std::vector<std::unique_ptr<Scanner>> chunks;
+    unsigned begin = 0;
+    for (unsigned i = 1; i <= threads && begin < size; i++)
+    {
+        unsigned end = size;
+        if (i < threads)
+        {
+            unsigned cut = std::max(begin, static_cast<unsigned>(uint64_t(size) * i / threads));
+            const char *newline = static_cast<const char *>(memchr(source.data() + cut, '\n', size - cut));
+            if (newline != nullptr)
+                end = static_cast<unsigned>(newline - source.data()) + 1;
+        }
+        chunks.push_back(std::unique_ptr<Scanner>(new Scanner(source.substr(0, end), begin, 1)));
+        begin = end;
+    }
+
+    RunInParallel(chunks.size(), [&chunks](size_t i)
+                  { chunks[i]->ScanChunk(); });
+    Stitch(chunks);
+}
+
+void Scanner::ScanChunk()
+{
+    // code rarely has more than a token every three characters; growing the vector instead would copy it several times
+    scanned.reserve((source.length() - current) / 3);
+    while (!IsAtEnd())
+    {
+        start = current;
+        has_token = false;
+        ScanToken();
+        if (has_token)
+            scanned.push_back(token);
+    }
+}
+
+void Scanner::Stitch(std::vector<std::unique_ptr<Scanner>> &chunks)
+{
+    SymbolTable &symbol_table = SymbolTable::Instance();
+    StringTable &string_table = StringTable::Instance();
+    std::vector<size_t> first_token(chunks.size());              // where each chunk's tokens go in scanned
+    std::vector<size_t> first_literal(chunks.size());            // and its literals in literals
+    std::vector<int> lines_before(chunks.size());                // the lines before each chunk, which it did not count
+    std::vector<std::vector<Symbol>> symbols(chunks.size());     // the symbols of each chunk's names
+    std::vector<std::vector<LoxString *>> strings(chunks.size()); // and its strings
+    size_t token_count = 0;
+    size_t literal_count = 0;
+    int lines = 0;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        const Scanner *previous = i > 0 ? chunks[i - 1].get() : nullptr;
+        if (previous != nullptr && previous->unterminated != NO_STRING)
+        {
+            // the chunk starts inside a string literal: scan it again from the opening quote, counting lines from the quote's
+            unsigned quote_line = previous->unterminated_line + lines_before[i - 1];
+            chunks[i].reset(new Scanner(chunks[i]->source, previous->unterminated, quote_line));
+            chunks[i]->ScanChunk();
+            lines = 0;
+        }
+        const Scanner &chunk = *chunks[i];
+        first_token[i] = token_count;
+        first_literal[i] = literal_count;
+        lines_before[i] = lines;
+
+        // interning what each chunk found first, chunk by chunk, numbers the names as scanning on demand would
+        for (std::string_view name : chunk.local_names.texts)
+            symbols[i].push_back(symbol_table.Intern(name));
+        for (std::string_view text : chunk.local_strings.texts)
+            strings[i].push_back(string_table.Intern(std::string(text)));
+
+        // the error of a string literal that continues in the next chunk is not one
+        bool string_continues = chunk.unterminated != NO_STRING && i + 1 < chunks.size();
+        for (size_t e = 0; e < chunk.errors.size() - (string_continues ? 1 : 0); e++)
+        {
+            const ScanError &error = chunk.errors[e];
+            errors.push_back(ScanError{token_count + error.token_index, error.line + lines, error.message});
+        }
+
+        token_count += chunk.scanned.size();
+        literal_count += chunk.literals.size();
+        lines += static_cast<int>(chunk.line) - 1;
+    }
+
+    // renumber the lines and symbols of the tokens, and fill in the strings, as they are copied into place
+    scanned.resize(token_count + 1);
+    literals.resize(literal_count);
+    RunInParallel(chunks.size(), [&](size_t i)
+                  {
+                      const Scanner &chunk = *chunks[i];
+                      Token *token = scanned.data() + first_token[i];
+                      TokenLiteral *literal = literals.data() + first_literal[i];
+                      const TokenLiteral *chunk_literal = chunk.literals.data();
+                      for (Token chunk_token : chunk.scanned)
+                      {
+                          chunk_token.line += lines_before[i];
+                          if (chunk_token.type == NUMBER)
+                          {
+                              *literal++ = *chunk_literal++;
+                          }
+                          else if (chunk_token.type == STRING)
+                          {
+                              *literal++ = TokenLiteral{chunk_token.start, strings[i][chunk_token.symbol]};
+                              chunk_literal++;
+                              chunk_token.symbol = SymbolTable::NONE;
+                          }
+                          else if (chunk_token.symbol != SymbolTable::NONE)
+                          {
+                              chunk_token.symbol = symbols[i][chunk_token.symbol];
+                          }
+                          *token++ = chunk_token;
+                      } });
+
+    current = static_cast<unsigned>(source.length());
+    line = static_cast<unsigned>(lines + 1);
+    scanned.back() = Token(END_OF_FILE, current, 0, line);
+    scanned_ahead = true;
+}
+
 void Scanner::ScanToken()
 {
     char c = Advance();
@@ -73,8 +271,7 @@ void Scanner::ScanToken()
     case '/':
         if (Match('/'))
         {
-            while (Peek() != '\n' && !IsAtEnd())
-                Advance();
+            SkipTo(kernels.FindLineEnd(Cursor(), End()));
         }
         else
         {
@@ -84,10 +281,12 @@ void Scanner::ScanToken()
     case ' ':
     case '\r':
     case '\t':
-        // Ignore whitespace.
-        break;
     case '\n':
-        line++;
+        // Ignore whitespace. Most runs are a single character; longer ones are skipped in one go.
+        if (c == '\n')
+            line++;
+        if (Peek() == ' ' || Peek() == '\t' || Peek() == '\r' || Peek() == '\n')
+            SkipTo(kernels.SkipWhitespace(Cursor(), End(), line));
         break;
     case '"':
         String();
@@ -103,7 +302,7 @@ void Scanner::ScanToken()
         }
         else
         {
-            Error::ReportError(line, "Unexpected character.");
+            ReportError("Unexpected character.");
         }
         break;
     }
@@ -135,19 +334,19 @@ char Scanner::Advance()
 
 void Scanner::AddToken(TokenType type)
 {
-    AddToken(type, nullptr);
+    token = Token(type, start, current - start, line);
+    has_token = true;
 }
 
 void Scanner::AddToken(TokenType type, Object literal)
 {
-    std::string text = source.substr(start, current - start);
-    tokens.push_back(Token(type, text, literal, line));
+    literals.push_back(TokenLiteral{start, literal});
+    AddToken(type);
 }
 
 void Scanner::Number()
 {
-    while (IsDigit(Peek()))
-        Advance();
+    SkipTo(kernels.SkipDigits(Cursor(), End()));
 
     // Look for a fractional part.
     if (Peek() == '.' && IsDigit(PeekNext()))
@@ -155,55 +354,61 @@ void Scanner::Number()
         // Consume the "."
         Advance();
 
-        while (IsDigit(Peek()))
-            Advance();
+        SkipTo(kernels.SkipDigits(Cursor(), End()));
     }
 
-    AddToken(NUMBER, std::stod(source.substr(start, current - start)));
+    double value = 0;
+    std::from_chars(source.data() + start, source.data() + current, value);
+    AddToken(NUMBER, value);
 }
 
 void Scanner::Identifier()
 {
-    while (IsAlphaNumeric(Peek()))
-        Advance();
+    SkipTo(kernels.SkipIdentifier(Cursor(), End()));
 
-    std::string text = source.substr(start, current - start);
-
-    TokenType type;
-    auto it = keywords.find(text);
-
-    if (it != keywords.end())
-    {
-        type = it->second;
-    }
+    std::string_view text = source.substr(start, current - start);
+    TokenType type = KeywordType(text);
+    // a chunk numbers its names itself, and they are interned when it is stitched
+    if (type == IDENTIFIER || type == THIS || type == SUPER)
+        token = Token(type, start, current - start, line, is_chunk ? local_names.Number(text) : SymbolTable::Instance().Intern(text));
     else
-    {
-        type = TokenType::IDENTIFIER;
-    }
-
-    AddToken(type);
+        token = Token(type, start, current - start, line);
+    has_token = true;
 }
 
 void Scanner::String()
 {
-    while (Peek() != '"' && !IsAtEnd())
-    {
-        if (Peek() == '\n')
-            line++;
-        Advance();
-    }
+    unsigned quote_line = line;
+    SkipTo(kernels.FindQuote(Cursor(), End(), line));
 
     if (IsAtEnd())
     {
-        Error::ReportError(line, "Unterminated string.");
+        unterminated = start;
+        unterminated_line = quote_line;
+        ReportError("Unterminated string.");
         return;
     }
 
     // The closing ".
     Advance();
 
+    if (current - start > Token::MAX_LENGTH)
+    {
+        ReportError("String too long.");
+        return;
+    }
+
     // Trim the surrounding quotes.
-    std::string value = source.substr(start + 1, current - start - 2);
+    std::string_view text = source.substr(start + 1, current - start - 2);
+    // a chunk's strings are interned when it is stitched
+    if (is_chunk)
+    {
+        AddToken(STRING, nullptr);
+        token.symbol = local_strings.Number(text);
+        return;
+    }
+
+    LoxString *value = StringTable::Instance().Intern(std::string(text));
     AddToken(STRING, value);
 }
 
@@ -230,9 +435,35 @@ bool Scanner::IsAlpha(char c)
            c == '_';
 }
 
-bool Scanner::IsAlphaNumeric(char c)
+uint32_t Scanner::LocalTable::Number(std::string_view text)
+{
+    auto found = numbers.emplace(text, static_cast<uint32_t>(texts.size()));
+    if (found.second)
+        texts.push_back(text);
+    return found.first->second;
+}
+
+void Scanner::ReportError(const char *message)
+{
+    if (is_chunk)
+        errors.push_back(ScanError{scanned.size(), static_cast<int>(line), message});
+    else
+        Error::ReportError(line, message);
+}
+
+const char *Scanner::Cursor()
+{
+    return source.data() + current;
+}
+
+const char *Scanner::End()
+{
+    return source.data() + source.length();
+}
+
+void Scanner::SkipTo(const char *position)
 {
-    return IsAlpha(c) || IsDigit(c);
+    current = position - source.data();
 }
 
 bool Scanner::IsAtEnd()
@@ -2,48 +2,96 @@
  * scanner.h
  * This file defines the Scanner class, which is used to scan the source code and generate a list of tokens.
  * The Scanner class includes methods for scanning individual tokens, checking the next character in the source code, and checking if the end of the source code has been reached.
+ *
+ * The Scanner does not copy the source: the tokens refer to it by offset, so the caller keeps it alive while they are used.
+ * NextToken scans just far enough to return the next token, so the Parser can pull tokens on demand without the whole file
+ * being turned into tokens first; ScanTokens collects all of them into a vector.
+ * The values of number and string literals go into a side table, in the order of the tokens, that the Parser reads with Literals.
+ *
+ * For very large sources, ScanInParallel splits the source into chunks at line breaks and scans them on several threads, with
+ * private chunk Scanners that neither intern names and strings nor report errors. Stitching the chunks back together, on the
+ * calling thread, rescans a chunk that turned out to start inside a string literal, renumbers the lines, interns in source order
+ * and keeps the errors, so NextToken then returns the same tokens, symbols and errors, at the same points, as scanning on demand.
+ *
+ * String literals are heap strings. The Scanner is a root source of the garbage collector that keeps them alive for as long as it exists,
+ * so the literal expressions built from them stay valid while the program runs.
  */
 #ifndef SCANNER_H
 #define SCANNER_H
 
+#include <memory>
 #include <string>
-#include <vector>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 #include "token.h"
 #include "token_type_enum.h"
+#include "garbage_collector.h"
+#include "scan_kernels.h"
 
-class Scanner
+class Scanner : public GcRootSource
 {
 public:
-    Scanner(std::string source);
+    Scanner(std::string_view source);
+    Scanner(const Scanner &) = delete;
+    ~Scanner();
+    // scans the next token; at the end of the source it returns END_OF_FILE tokens
+    Token NextToken();
     std::vector<Token> ScanTokens();
+    // scans the whole source with up to threads threads, before any token is taken; NextToken then returns the tokens it found
+    void ScanInParallel(unsigned threads);
+    // the values of the NUMBER and STRING tokens, by the start of their token
+    const std::vector<TokenLiteral> &Literals() const { return literals; }
+    // marks the string literals
+    void MarkRoots(GarbageCollector &gc) override;
 
 private:
-    const std::string source;
-    std::vector<Token> tokens;
+    // an error found by a chunk Scanner, reported when NextToken reaches the token it came before
+    struct ScanError
+    {
+        size_t token_index;
+        int line;
+        std::string message;
+    };
+
+    // the distinct names, or string literals, of a chunk, numbered in the order they first appear, until the chunk is stitched
+    struct LocalTable
+    {
+        std::unordered_map<std::string_view, uint32_t> numbers;
+        std::vector<std::string_view> texts;
+
+        uint32_t Number(std::string_view text);
+    };
+
+    static constexpr unsigned MIN_CHUNK_SIZE = 1 << 20; // smaller chunks are not worth a thread
+    static constexpr unsigned NO_STRING = UINT32_MAX;
+
+    const std::string_view source;
+    const ScanKernels &kernels;         // the fastest kernels the processor supports
+    Token token;                        // the token the last ScanToken produced
+    bool has_token = false;             // whether it produced one
+    std::vector<TokenLiteral> literals; // the values of the literals scanned so far
     unsigned start = 0;
     unsigned current = 0;
     unsigned line = 1;
+    bool is_chunk = false;              // whether this is a chunk Scanner of ScanInParallel
+    bool scanned_ahead = false;         // whether ScanInParallel has filled scanned
+    std::vector<Token> scanned;         // the tokens scanned ahead, or those of a chunk
+    size_t next_scanned = 0;            // the next of them NextToken returns
+    std::vector<ScanError> errors;      // the errors found while scanning ahead
+    size_t next_error = 0;              // the next of them NextToken reports
+    unsigned unterminated = NO_STRING;  // where a chunk's unterminated string literal begins
+    unsigned unterminated_line = 0;     // and its line
+    LocalTable local_names;             // a chunk's names, whose tokens hold their numbers as symbols
+    LocalTable local_strings;           // a chunk's string literals, whose tokens hold their numbers the same way
+
+    // a Scanner for the chunk of source that starts at begin and ends with the source, which starts counting lines at line
+    Scanner(std::string_view source, unsigned begin, unsigned line);
+    void ScanChunk();                                           // scan a chunk into tokens
+    void Stitch(std::vector<std::unique_ptr<Scanner>> &chunks); // join the scanned chunks into tokens
+    void ReportError(const char *message);                      // report an error at the current line, or keep a chunk's
 
-    std::unordered_map<std::string, TokenType> keywords = {
-        {"and", TokenType::AND},
-        {"class", TokenType::CLASS},
-        {"else", TokenType::ELSE},
-        {"false", TokenType::FALSE},
-        {"for", TokenType::FOR},
-        {"fun", TokenType::FUN},
-        {"if", TokenType::IF},
-        {"nil", TokenType::NIL},
-        {"or", TokenType::OR},
-        {"print", TokenType::PRINT},
-        {"return", TokenType::RETURN},
-        {"super", TokenType::SUPER},
-        {"this", TokenType::THIS},
-        {"true", TokenType::TRUE},
-        {"var", TokenType::VAR},
-        {"while", TokenType::WHILE}};
-
-    void ScanToken(); // scan the source code and generate a list of tokens
+    void ScanToken(); // scan one lexeme, which produces at most one token
     char Peek();      // check the current character
     char PeekNext();  // check the next character
     char Advance();   // advance the current character
@@ -55,7 +103,9 @@ private:
     bool IsDigit(char c);
     bool Match(const char expected); // check if the current character matches the expected character
     bool IsAlpha(char c);
-    bool IsAlphaNumeric(char c);
     bool IsAtEnd();
+    const char *Cursor();              // the current character
+    const char *End();                 // just past the last character
+    void SkipTo(const char *position); // make position the current character
 };
 #endif // SCANNER_H
\ No newline at end of file
@@ -0,0 +1,37 @@
+/*
+ * shape.cpp
+ * This file implements the Shape class defined in shape.h.
+ *
+ * The AddField method looks the transition up first; only the first instance to take a transition creates the child shape, which
+ * copies the parent's slots and appends the new field.
+ */
+#include "shape.h"
+
+uint64_t Shape::next_id = 0;
+
+Shape::Shape() : id(next_id++) {}
+
+Shape::~Shape()
+{
+    for (auto it = transitions.begin(); it != transitions.end(); it++)
+        delete it->second;
+}
+int Shape::Find(Symbol name) const
+{
+    auto it = slots.find(name);
+    if (it != slots.end())
+        return it->second;
+    return -1;
+}
+Shape *Shape::AddField(Symbol name)
+{
+    auto it = transitions.find(name);
+    if (it != transitions.end())
+        return it->second;
+
+    Shape *child = new Shape();
+    child->slots = slots;
+    child->slots.emplace(name, FieldCount());
+    transitions.emplace(name, child);
+    return child;
+}
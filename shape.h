@@ -0,0 +1,45 @@
+/*
+ * shape.h
+ * This file defines the Shape class, the hidden class that describes the layout of the fields of LoxInstances.
+ *
+ * A shape maps the symbol of each field name to a slot, the index of the field's value in the instance's field array. Instances that received the
+ * same fields in the same order share one shape, so the names are stored once per shape instead of once per instance.
+ *
+ * Shapes form a tree. Every class owns an empty root shape for its instances, and adding a field to an instance moves it to a child
+ * shape (a transition). The transition for a name is created the first time it is taken and reused afterwards, so a shape always
+ * has the same slots for the same names and a field read is a lookup in the shape plus an indexed load.
+ *
+ * A shape owns its transitions and deletes them when it is deleted; the root shape lives as long as its class.
+ *
+ * Every shape has an id that is unique for the whole run, which the property caches use as the key of their entries.
+ */
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include "symbol_table.h"
+
+class Shape
+{
+public:
+    Shape();
+    Shape(const Shape &) = delete;
+    ~Shape();
+    // returns the slot of the named field, or -1 if the shape has no such field
+    int Find(Symbol name) const;
+    // returns the shape with one more field, the named one, in the next slot
+    Shape *AddField(Symbol name);
+    // returns the number of fields, which is also the next free slot
+    int FieldCount() const { return static_cast<int>(slots.size()); }
+    uint64_t Id() const { return id; }
+
+private:
+    static uint64_t next_id;
+
+    const uint64_t id;
+    std::unordered_map<Symbol, int> slots;             // the slot of every field, by its symbol
+    std::unordered_map<Symbol, Shape *> transitions; // the child shapes, by the symbol of the field they add
+};
+
+#endif // SHAPE_H
@@ -0,0 +1,57 @@
+/*
+ * source_file.cpp
+ * This file implements the SourceFile class defined in source_file.h.
+ *
+ * The Open method maps regular, non-empty files with mmap and tells the kernel they will be read sequentially. For any other file, or if
+ * the mapping fails, ReadAll reads the descriptor to the end into one string.
+ *
+ * The destructor unmaps the file if it was mapped.
+ */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "source_file.h"
+
+SourceFile::~SourceFile()
+{
+    if (mapping != nullptr)
+        munmap(mapping, mapping_size);
+}
+bool SourceFile::Open(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void *address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED)
+        {
+            mapping = address;
+            mapping_size = info.st_size;
+            madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+            close(fd);
+            return true;
+        }
+    }
+
+    ReadAll(fd);
+    close(fd);
+    return true;
+}
+std::string_view SourceFile::Text() const
+{
+    if (mapping != nullptr)
+        return std::string_view(static_cast<const char *>(mapping), mapping_size);
+    return contents;
+}
+void SourceFile::ReadAll(int fd)
+{
+    char buffer[64 * 1024];
+    ssize_t count;
+    while ((count = read(fd, buffer, sizeof(buffer))) > 0)
+        contents.append(buffer, count);
+}
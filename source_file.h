@@ -0,0 +1,37 @@
+/*
+ * source_file.h
+ * This file defines the SourceFile class, which loads a Lox script for RunFile without copying it more than needed.
+ *
+ * The Open method maps a regular file read-only into memory, so only the pages the Scanner actually reads are loaded. Anything that
+ * cannot be mapped (a pipe, a terminal, an empty file) is read once into a string instead. It returns false if the file cannot be opened.
+ *
+ * The Text method returns a view of the whole script. The view, and every token that refers to it, is valid until the SourceFile is
+ * destroyed, which unmaps the file.
+ */
+#ifndef SOURCE_FILE_H
+#define SOURCE_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+class SourceFile
+{
+public:
+    SourceFile() = default;
+    SourceFile(const SourceFile &) = delete;
+    SourceFile &operator=(const SourceFile &) = delete;
+    ~SourceFile();
+
+    bool Open(const std::string &path);
+    std::string_view Text() const;
+
+private:
+    void *mapping = nullptr; // the mapped file, or nullptr if it was read instead
+    size_t mapping_size = 0;
+    std::string contents; // the file, if it could not be mapped
+
+    void ReadAll(int fd);
+};
+
+#endif // SOURCE_FILE_H
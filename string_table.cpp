@@ -0,0 +1,82 @@
+/*
+ * string_table.cpp
+ * This file implements the StringTable class defined in string_table.h.
+ *
+ * The Intern method hashes the characters once, probes for them, and allocates a new LoxString only when they are not found; the
+ * collector charges the new string's characters to the heap.
+ * The table grows to twice its size once it is three quarters full.
+ *
+ * The SweepWeakReferences method rebuilds the table from the strings that survived the collection. A collection visits the whole
+ * heap anyway, so rebuilding is cheap by comparison, and the table never needs tombstones.
+ */
+#include "string_table.h"
+#include "lox_string.h"
+
+StringTable &StringTable::Instance()
+{
+    static StringTable table;
+    return table;
+}
+StringTable::StringTable() : entries(INITIAL_CAPACITY, nullptr)
+{
+    GarbageCollector::Instance().AddRootSource(this);
+}
+StringTable::~StringTable()
+{
+    GarbageCollector::Instance().RemoveRootSource(this);
+}
+uint32_t StringTable::Hash(std::string_view chars)
+{
+    uint32_t hash = 2166136261u;
+    for (char c : chars)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+LoxString *StringTable::Intern(std::string chars)
+{
+    uint32_t hash = Hash(chars);
+    size_t bucket = FindBucket(chars, hash);
+    if (entries[bucket] != nullptr)
+        return entries[bucket];
+
+    LoxString *string = GarbageCollector::Instance().Allocate<LoxString>(std::move(chars), hash);
+    entries[bucket] = string;
+    count++;
+    if (count * 4 > entries.size() * 3)
+        Rebuild(entries.size() * 2, [](LoxString *) { return true; });
+    return string;
+}
+void StringTable::SweepWeakReferences(GarbageCollector &gc)
+{
+    Rebuild(entries.size(), [&gc](LoxString *string) { return gc.IsMarked(string); });
+}
+size_t StringTable::FindBucket(std::string_view chars, uint32_t hash) const
+{
+    size_t mask = entries.size() - 1;
+    size_t bucket = hash & mask;
+    while (entries[bucket] != nullptr && (entries[bucket]->hash != hash || entries[bucket]->chars != chars))
+        bucket = (bucket + 1) & mask;
+    return bucket;
+}
+template <typename Filter>
+void StringTable::Rebuild(size_t capacity, Filter keep)
+{
+    std::vector<LoxString *> old_entries(capacity, nullptr);
+    old_entries.swap(entries);
+    count = 0;
+
+    size_t mask = capacity - 1;
+    for (LoxString *string : old_entries)
+    {
+        if (string == nullptr || !keep(string))
+            continue;
+        size_t bucket = string->hash & mask;
+        while (entries[bucket] != nullptr)
+            bucket = (bucket + 1) & mask;
+        entries[bucket] = string;
+        count++;
+    }
+}
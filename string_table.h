@@ -0,0 +1,56 @@
+/*
+ * string_table.h
+ * This file defines the StringTable class, the process-wide intern table of the tree-walking interpreter's strings.
+ *
+ * Every LoxString is created by Intern, which returns the existing string when one with the same characters is already interned.
+ * Two equal strings are therefore always the same object: comparing strings is a pointer compare, and passing one around copies a pointer.
+ *
+ * The table is an open-addressing hash set with linear probing. Each string carries the FNV-1a hash of its characters, computed once
+ * when it is created, so growing the table and probing past other entries never hash characters again.
+ *
+ * The table holds its strings weakly: it is a root source of the garbage collector that marks nothing, and drops the strings that
+ * were not marked just before the collector frees them.
+ */
+#ifndef STRING_TABLE_H
+#define STRING_TABLE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "garbage_collector.h"
+
+class LoxString;
+
+class StringTable : public GcRootSource
+{
+public:
+    // the table shared by the whole process
+    static StringTable &Instance();
+    ~StringTable();
+    // returns the interned string with the given characters, creating it if needed
+    LoxString *Intern(std::string chars);
+    // returns the FNV-1a hash of some characters
+    static uint32_t Hash(std::string_view chars);
+
+    // marks nothing: the table holds its strings weakly
+    void MarkRoots(GarbageCollector &) override {}
+    // removes the strings that are about to be freed
+    void SweepWeakReferences(GarbageCollector &gc) override;
+
+private:
+    static const size_t INITIAL_CAPACITY = 64;
+
+    StringTable();
+
+    std::vector<LoxString *> entries; // a power-of-two number of buckets; nullptr marks an empty one
+    size_t count = 0;
+
+    // returns the bucket holding the string, or the empty bucket where it belongs
+    size_t FindBucket(std::string_view chars, uint32_t hash) const;
+    // rebuilds the table with the given capacity, keeping only the strings the filter accepts
+    template <typename Filter>
+    void Rebuild(size_t capacity, Filter keep);
+};
+
+#endif // STRING_TABLE_H
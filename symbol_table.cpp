@@ -0,0 +1,32 @@
+/*
+ * symbol_table.cpp
+ * This file implements the SymbolTable class defined in symbol_table.h.
+ *
+ * The constructor interns the names with fixed symbols first, in the order of their ids.
+ *
+ * The Intern method returns the id of a known name, or stores a copy of the name and gives it the next id.
+ */
+#include "symbol_table.h"
+
+SymbolTable &SymbolTable::Instance()
+{
+    static SymbolTable table;
+    return table;
+}
+SymbolTable::SymbolTable()
+{
+    Intern("init");
+    Intern("this");
+    Intern("super");
+}
+Symbol SymbolTable::Intern(std::string_view name)
+{
+    auto it = ids.find(name);
+    if (it != ids.end())
+        return it->second;
+
+    Symbol symbol = static_cast<Symbol>(names.size());
+    names.emplace_back(name);
+    ids.emplace(names.back(), symbol);
+    return symbol;
+}
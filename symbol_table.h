@@ -0,0 +1,53 @@
+/*
+ * symbol_table.h
+ * This file defines the SymbolTable class, the process-wide table that gives every identifier of the tree-walking interpreter
+ * an integer id, its Symbol.
+ *
+ * The Scanner interns each identifier (and the "this" and "super" keywords) once, when it scans it, and stores the symbol in the token.
+ * From then on every name-based lookup (globals, fields, methods, the Resolver's scopes) is keyed by the symbol, so no name is
+ * hashed or compared as a string again.
+ *
+ * Symbols are dense, starting at 0, and never freed: the names of a program are bounded by the size of its source. The names
+ * that the runtime looks up by itself have fixed symbols: INIT, THIS and SUPER.
+ *
+ * Name returns the characters of a symbol, for error messages. Count returns how many there are, which is how large a table indexed by
+ * symbol must be.
+ */
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+using Symbol = uint32_t;
+
+class SymbolTable
+{
+public:
+    static constexpr Symbol INIT = 0;
+    static constexpr Symbol THIS = 1;
+    static constexpr Symbol SUPER = 2;
+    // the symbol of tokens that are not names
+    static constexpr Symbol NONE = UINT32_MAX;
+
+    // the table shared by the whole process
+    static SymbolTable &Instance();
+    SymbolTable(const SymbolTable &) = delete;
+    // returns the symbol of the name, giving it the next id the first time it is seen
+    Symbol Intern(std::string_view name);
+    // returns the characters of a symbol
+    const std::string &Name(Symbol symbol) const { return names[symbol]; }
+    // returns the number of symbols, one more than the highest
+    size_t Count() const { return names.size(); }
+
+private:
+    SymbolTable();
+
+    std::deque<std::string> names;                  // the names, by symbol; a deque never moves them, so the keys below stay valid
+    std::unordered_map<std::string_view, Symbol> ids; // the symbols, by name
+};
+
+#endif // SYMBOL_TABLE_H
@@ -1,33 +1,58 @@
 /*
  * token.h
  * This file defines the Token class, which represents a lexical token in the source code.
- * Each Token has a type, a lexeme, a literal value, and the line number where it was found in the source code.
+ * Each Token has a type, the position of its lexeme in the source, its symbol, and the line number where it was found in the source code.
+ * The symbol (see symbol_table.h) is set for identifiers and the "this" and "super" keywords, and is SymbolTable::NONE otherwise.
+ * A Token is 16 bytes and owns nothing; to fit, the type and the length share a word, so a lexeme is at most MAX_LENGTH bytes.
+ * The lexeme is read back from the source being run, which the Scanner registers with SetSource and which must stay alive while
+ * the tokens and the syntax tree built from them are used.
+ * The value of a NUMBER or STRING token is not stored in the token; the Scanner records it in a side table of TokenLiterals,
+ * found by the token's start.
  * The Token class includes a method for converting a Token to a string for debugging purposes.
  */
 #ifndef TOKEN_H
 #define TOKEN_H
 
-#include <variant>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "object.h"
+#include "symbol_table.h"
 #include "token_type_enum.h"
 #include "token_type_functions.h"
 
-class LoxCallable;
-class LoxClass;
-class LoxInstance;
-
-#define Object std::variant<double, bool, std::string, std::nullptr_t, LoxCallable *, LoxClass *, LoxInstance *>
-
 class Token
 {
 public:
     Token() = default;
-    Token(TokenType type, const std::string lexeme, Object literal, int line);
+    Token(TokenType type, uint32_t start, uint32_t length, int line, Symbol symbol = SymbolTable::NONE);
+    // the characters of the token in the source
+    std::string_view Lexeme() const { return std::string_view(source.data() + start, length); }
     std::string ToString() const;
+    // sets the source that the lexemes of new tokens refer to
+    static void SetSource(std::string_view text);
+
+    // the length of the largest source whose offsets fit in a token
+    static const size_t MAX_SOURCE_SIZE = UINT32_MAX;
+    static constexpr uint32_t MAX_LENGTH = (1u << 24) - 1;
+
+    uint32_t start;       // the offset of the lexeme in the source
+    uint32_t length : 24; // the length of the lexeme
+    TokenType type : 8;   // the type of the token
+    Symbol symbol;        // the symbol of a name
+    int line;             // the line number where the token was found in the source code
 
-    TokenType type;     // the type of the token
-    std::string lexeme; // the lexeme of the token
-    Object literal;     // the literal value of the token
-    int line;           // the line number where the token was found in the source code
+private:
+    static std::string_view source;
+};
+
+static_assert(sizeof(Token) == 16, "a Token must stay compact");
+
+// the value of a NUMBER or STRING token, found by the start of the token
+struct TokenLiteral
+{
+    uint32_t start;
+    Object value;
 };
 
-#endif // TOKEN_H
\ No newline at end of file
+#endif // TOKEN_H
@@ -2,13 +2,32 @@
  * token_type_functions.h
  * This file declares the TokenType2String function, which converts a TokenType enum value to a string.
  * This function is used for debugging and error reporting purposes.
+ *
+ * The names are kept in a constexpr table indexed by the TokenType, so TokenTypeName can be evaluated at compile time.
  */
 #ifndef TOKEN_TYPE_FUNCTIONS_H
 #define TOKEN_TYPE_FUNCTIONS_H
 
+#include <iterator>
 #include <string>
+#include <string_view>
 #include "token_type_enum.h"
 
+// the name of every TokenType, in the order of the enum
+inline constexpr std::string_view TOKEN_TYPE_NAMES[] = {
+    "LEFT_PAREN", "RIGHT_PAREN", "LEFT_BRACE", "RIGHT_BRACE", "COMMA", "DOT", "MINUS", "PLUS", "SEMICOLON", "SLASH", "STAR",
+    "BANG", "BANG_EQUAL", "EQUAL", "EQUAL_EQUAL", "GREATER", "GREATER_EQUAL", "LESS", "LESS_EQUAL",
+    "IDENTIFIER", "STRING", "NUMBER",
+    "AND", "CLASS", "ELSE", "FALSE", "FUN", "FOR", "IF", "NIL", "OR", "PRINT", "RETURN", "SUPER", "THIS", "TRUE", "VAR", "WHILE",
+    "END_OF_FILE"};
+
+static_assert(std::size(TOKEN_TYPE_NAMES) == END_OF_FILE + 1, "every TokenType needs a name");
+
+constexpr std::string_view TokenTypeName(TokenType tokenType)
+{
+    return tokenType >= 0 && tokenType <= END_OF_FILE ? TOKEN_TYPE_NAMES[tokenType] : "UNKNOWN";
+}
+
 std::string TokenType2String(TokenType tokenType);
 
-#endif // TOKEN_TYPE_FUNCTIONS_H
\ No newline at end of file
+#endif // TOKEN_TYPE_FUNCTIONS_H
@@ -2,19 +2,37 @@
  * visit_call_expr.h
  * This file defines the LoxCallable interface, which represents a callable object in the Lox language.
  * Each LoxCallable object must implement the Call method, which is used to call the object with a given list of arguments, and the Arity method, which returns the number of arguments that the object takes.
+ * Callables live on the garbage-collected heap, so every LoxCallable is also a GcObject.
+ *
+ * The arguments are passed as an Arguments span over the Interpreter's value stack, where the caller evaluated them, so a call does not
+ * copy them into a list of its own. The span is only valid until the callee runs Lox code, which may grow the stack and move it, so a
+ * callee binds the arguments to its parameters before it does anything else.
  */
 #ifndef VISIT_CALL_EXPR_H
 #define VISIT_CALL_EXPR_H
 
+#include <cstddef>
 #include "token.h"
-#include <vector>
+#include "garbage_collector.h"
 
 class Interpreter;
 
-class LoxCallable
+// the arguments of a call, on the caller's value stack
+struct Arguments
+{
+    const Object *values;
+    size_t count;
+
+    const Object &operator[](size_t i) const { return values[i]; }
+    size_t size() const { return count; }
+    const Object *begin() const { return values; }
+    const Object *end() const { return values + count; }
+};
+
+class LoxCallable : public GcObject
 {
 public:
-    virtual Object Call(Interpreter *interpreter, std::vector<Object> arguments) = 0;
+    virtual Object Call(Interpreter *interpreter, Arguments arguments) = 0;
     virtual int Arity() = 0;
     virtual ~LoxCallable() {}
 };
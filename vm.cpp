@@ -0,0 +1,546 @@
+/*
+ * vm.cpp
+ * This file implements the VM class defined in vm.h.
+ *
+ * The Run method is the interpreter loop. It keeps the instruction pointer, the frame's first slot and its constant pool in locals,
+ * and only writes the instruction pointer back to the CallFrame before a call or before raising an error. It dispatches on the opcode
+ * without its OP_LONG bit, so the wide form of an instruction runs the same code and only reads a longer constant operand.
+ *
+ * Runtime errors are raised by throwing the same RuntimeError the tree-walker throws, so the messages, the "[line N] RuntimeError."
+ * report and the exit code are identical between the two engines.
+ *
+ * Method calls of the form receiver.name(args) are compiled to OP_INVOKE, which looks the method up and calls it in place,
+ * so no ObjBoundMethod is created unless the method is read as a value.
+ *
+ * Objects are allocated through the garbage collector. The VM's roots are the stack, the closures of the active frames, the open
+ * upvalues, the globals and the "init" string; the intern table only holds its strings weakly. A pending collection runs when a
+ * call frame has been pushed and at the back edge of every loop, where everything live is on the stack or in a frame.
+ */
+#include <iostream>
+#include "vm.h"
+#include "error.h"
+#include "runtime_error.h"
+
+VM::VM()
+{
+    stack = new Value[STACK_MAX];
+    stack_top = stack;
+    init_string = CopyString("init");
+    GarbageCollector::Instance().AddRootSource(this);
+}
+VM::~VM()
+{
+    GarbageCollector::Instance().RemoveRootSource(this);
+    delete[] stack;
+}
+template <typename T, typename... Args>
+T *VM::Allocate(Args &&...args)
+{
+    return GarbageCollector::Instance().Allocate<T>(std::forward<Args>(args)...);
+}
+void VM::MarkRoots(GarbageCollector &gc)
+{
+    for (Value *slot = stack; slot < stack_top; slot++)
+        ::MarkValue(gc, *slot);
+    for (int i = 0; i < frame_count; i++)
+        gc.Mark(frames[i].closure);
+    for (ObjUpvalue *upvalue = open_upvalues; upvalue != nullptr; upvalue = upvalue->next_open)
+        gc.Mark(upvalue);
+    for (auto it = globals.begin(); it != globals.end(); it++)
+    {
+        gc.Mark(it->first);
+        ::MarkValue(gc, it->second);
+    }
+    gc.Mark(init_string);
+}
+void VM::SweepWeakReferences(GarbageCollector &gc)
+{
+    for (auto it = strings.begin(); it != strings.end();)
+    {
+        if (gc.IsMarked(it->second))
+            it++;
+        else
+            it = strings.erase(it);
+    }
+}
+ObjString *VM::CopyString(std::string_view chars)
+{
+    auto it = strings.find(chars);
+    if (it != strings.end())
+        return it->second;
+
+    ObjString *string = Allocate<ObjString>(std::string(chars));
+    strings.emplace(string->chars, string);
+    return string;
+}
+ObjFunction *VM::NewFunction()
+{
+    return Allocate<ObjFunction>();
+}
+void VM::Interpret(ObjFunction *script)
+{
+    ObjClosure *closure = Allocate<ObjClosure>(script);
+    Push(Value::FromObj(closure));
+    try
+    {
+        Call(closure, 0);
+        Run();
+    }
+    catch (const ::RuntimeError &error)
+    {
+        Error::ProcessRuntimeError(error);
+        stack_top = stack;
+        frame_count = 0;
+        open_upvalues = nullptr;
+    }
+}
+void VM::Run()
+{
+    CallFrame *frame = &frames[frame_count - 1];
+    uint8_t *ip = frame->ip;
+    Value *slots = frame->slots;
+    Value *constants = frame->closure->function->chunk.constants.data();
+    uint8_t instruction = 0;
+
+    auto load_frame = [&]()
+    {
+        frame = &frames[frame_count - 1];
+        ip = frame->ip;
+        slots = frame->slots;
+        constants = frame->closure->function->chunk.constants.data();
+    };
+    auto read_byte = [&]()
+    { return *ip++; };
+    auto read_short = [&]()
+    {
+        ip += 2;
+        return static_cast<uint16_t>((ip[-2] << 8) | ip[-1]);
+    };
+    auto read_long = [&]()
+    {
+        ip += 3;
+        return static_cast<uint32_t>((ip[-3] << 16) | (ip[-2] << 8) | ip[-1]);
+    };
+    // reads the constant operand of the current instruction, 24 bits wide in its wide form
+    auto read_constant = [&]()
+    { return constants[(instruction & OP_LONG) ? read_long() : read_short()]; };
+    auto read_string = [&]()
+    { return static_cast<ObjString *>(read_constant().AsObj()); };
+    auto fail = [&](const std::string &message)
+    {
+        frame->ip = ip;
+        ThrowRuntimeError(message);
+    };
+    auto check_numbers = [&]()
+    {
+        if (!stack_top[-1].IsNumber() || !stack_top[-2].IsNumber())
+            fail("Operands must be numbers.");
+    };
+
+    while (true)
+    {
+        instruction = read_byte();
+        switch (instruction & ~OP_LONG)
+        {
+        case OP_CONSTANT:
+            Push(read_constant());
+            break;
+        case OP_NIL:
+            Push(Value::Nil());
+            break;
+        case OP_TRUE:
+            Push(Value::Bool(true));
+            break;
+        case OP_FALSE:
+            Push(Value::Bool(false));
+            break;
+        case OP_POP:
+            stack_top--;
+            break;
+        case OP_GET_LOCAL:
+            Push(slots[read_byte()]);
+            break;
+        case OP_SET_LOCAL:
+            slots[read_byte()] = stack_top[-1];
+            break;
+        case OP_GET_GLOBAL:
+        {
+            ObjString *name = read_string();
+            auto it = globals.find(name);
+            if (it == globals.end())
+                fail("Undefined variable '" + name->chars + "'.");
+            Push(it->second);
+            break;
+        }
+        case OP_DEFINE_GLOBAL:
+            globals[read_string()] = Pop();
+            break;
+        case OP_SET_GLOBAL:
+        {
+            ObjString *name = read_string();
+            auto it = globals.find(name);
+            if (it == globals.end())
+                fail("Undefined variable '" + name->chars + "'.");
+            it->second = stack_top[-1];
+            break;
+        }
+        case OP_GET_UPVALUE:
+            Push(*frame->closure->upvalues[read_byte()]->location);
+            break;
+        case OP_SET_UPVALUE:
+            *frame->closure->upvalues[read_byte()]->location = stack_top[-1];
+            break;
+        case OP_GET_PROPERTY:
+        {
+            ObjString *name = read_string();
+            if (!IsObjType(stack_top[-1], ObjType::INSTANCE))
+                fail("Only instances have properties.");
+
+            ObjInstance *instance = static_cast<ObjInstance *>(stack_top[-1].AsObj());
+            auto it = instance->fields.find(name);
+            if (it != instance->fields.end())
+            {
+                stack_top[-1] = it->second;
+                break;
+            }
+            frame->ip = ip;
+            BindMethod(instance->klass, name);
+            break;
+        }
+        case OP_SET_PROPERTY:
+        {
+            ObjString *name = read_string();
+            if (!IsObjType(stack_top[-2], ObjType::INSTANCE))
+                fail("Only instances have fields.");
+
+            ObjInstance *instance = static_cast<ObjInstance *>(stack_top[-2].AsObj());
+            instance->fields[name] = stack_top[-1];
+            stack_top[-2] = stack_top[-1];
+            stack_top--;
+            break;
+        }
+        case OP_GET_SUPER:
+        {
+            ObjString *name = read_string();
+            ObjClass *superclass = static_cast<ObjClass *>(Pop().AsObj());
+            frame->ip = ip;
+            BindMethod(superclass, name);
+            break;
+        }
+        case OP_EQUAL:
+            stack_top[-2] = Value::Bool(ValuesEqual(stack_top[-2], stack_top[-1]));
+            stack_top--;
+            break;
+        case OP_NOT_EQUAL:
+            stack_top[-2] = Value::Bool(!ValuesEqual(stack_top[-2], stack_top[-1]));
+            stack_top--;
+            break;
+        case OP_GREATER:
+            check_numbers();
+            stack_top[-2] = Value::Bool(stack_top[-2].AsNumber() > stack_top[-1].AsNumber());
+            stack_top--;
+            break;
+        case OP_GREATER_EQUAL:
+            check_numbers();
+            stack_top[-2] = Value::Bool(stack_top[-2].AsNumber() >= stack_top[-1].AsNumber());
+            stack_top--;
+            break;
+        case OP_LESS:
+            check_numbers();
+            stack_top[-2] = Value::Bool(stack_top[-2].AsNumber() < stack_top[-1].AsNumber());
+            stack_top--;
+            break;
+        case OP_LESS_EQUAL:
+            check_numbers();
+            stack_top[-2] = Value::Bool(stack_top[-2].AsNumber() <= stack_top[-1].AsNumber());
+            stack_top--;
+            break;
+        case OP_ADD:
+            if (stack_top[-1].IsNumber() && stack_top[-2].IsNumber())
+            {
+                stack_top[-2] = Value::Number(stack_top[-2].AsNumber() + stack_top[-1].AsNumber());
+                stack_top--;
+            }
+            else if (IsObjType(stack_top[-1], ObjType::STRING) && IsObjType(stack_top[-2], ObjType::STRING))
+            {
+                Concatenate();
+            }
+            else
+            {
+                fail("Operands must be two numbers or two strings.");
+            }
+            break;
+        case OP_SUBTRACT:
+            check_numbers();
+            stack_top[-2] = Value::Number(stack_top[-2].AsNumber() - stack_top[-1].AsNumber());
+            stack_top--;
+            break;
+        case OP_MULTIPLY:
+            check_numbers();
+            stack_top[-2] = Value::Number(stack_top[-2].AsNumber() * stack_top[-1].AsNumber());
+            stack_top--;
+            break;
+        case OP_DIVIDE:
+            check_numbers();
+            stack_top[-2] = Value::Number(stack_top[-2].AsNumber() / stack_top[-1].AsNumber());
+            stack_top--;
+            break;
+        case OP_NOT:
+            stack_top[-1] = Value::Bool(IsFalsey(stack_top[-1]));
+            break;
+        case OP_NEGATE:
+            if (!stack_top[-1].IsNumber())
+                fail("Operand must be a number.");
+            stack_top[-1] = Value::Number(-stack_top[-1].AsNumber());
+            break;
+        case OP_PRINT:
+            std::cout << Stringify(Pop()) << '\n';
+            break;
+        case OP_JUMP:
+        {
+            uint32_t offset = read_long();
+            ip += offset;
+            break;
+        }
+        case OP_JUMP_IF_FALSE:
+        {
+            uint32_t offset = read_long();
+            if (IsFalsey(stack_top[-1]))
+                ip += offset;
+            break;
+        }
+        case OP_LOOP:
+        {
+            uint32_t offset = read_long();
+            ip -= offset;
+            GarbageCollector &gc = GarbageCollector::Instance();
+            if (gc.ShouldCollect())
+                gc.Collect();
+            break;
+        }
+        case OP_CALL:
+        {
+            int argc = read_byte();
+            frame->ip = ip;
+            CallValue(Peek(argc), argc);
+            load_frame();
+            break;
+        }
+        case OP_INVOKE:
+        {
+            ObjString *name = read_string();
+            int argc = read_byte();
+            frame->ip = ip;
+            Invoke(name, argc);
+            load_frame();
+            break;
+        }
+        case OP_SUPER_INVOKE:
+        {
+            ObjString *name = read_string();
+            int argc = read_byte();
+            ObjClass *superclass = static_cast<ObjClass *>(Pop().AsObj());
+            frame->ip = ip;
+            InvokeFromClass(superclass, name, argc);
+            load_frame();
+            break;
+        }
+        case OP_CLOSURE:
+        {
+            ObjFunction *function = static_cast<ObjFunction *>(read_constant().AsObj());
+            ObjClosure *closure = Allocate<ObjClosure>(function);
+            Push(Value::FromObj(closure));
+            for (int i = 0; i < function->upvalue_count; i++)
+            {
+                uint8_t is_local = read_byte();
+                uint8_t index = read_byte();
+                if (is_local)
+                    closure->upvalues[i] = CaptureUpvalue(slots + index);
+                else
+                    closure->upvalues[i] = frame->closure->upvalues[index];
+            }
+            break;
+        }
+        case OP_CLOSE_UPVALUE:
+            CloseUpvalues(stack_top - 1);
+            stack_top--;
+            break;
+        case OP_RETURN:
+        {
+            Value result = Pop();
+            CloseUpvalues(slots);
+            frame_count--;
+            if (frame_count == 0)
+            {
+                stack_top--;
+                return;
+            }
+
+            stack_top = slots;
+            Push(result);
+            load_frame();
+            break;
+        }
+        case OP_CLASS:
+            Push(Value::FromObj(Allocate<ObjClass>(read_string())));
+            break;
+        case OP_INHERIT:
+        {
+            if (!IsObjType(stack_top[-2], ObjType::CLASS))
+                fail("Superclass must be a class.");
+
+            ObjClass *superclass = static_cast<ObjClass *>(stack_top[-2].AsObj());
+            ObjClass *subclass = static_cast<ObjClass *>(stack_top[-1].AsObj());
+            subclass->methods = superclass->methods;
+            subclass->initializer = superclass->initializer;
+            stack_top--;
+            break;
+        }
+        case OP_METHOD:
+            DefineMethod(read_string());
+            break;
+        }
+    }
+}
+void VM::CallValue(Value callee, int argc)
+{
+    if (callee.IsObj())
+    {
+        switch (callee.AsObj()->type)
+        {
+        case ObjType::CLOSURE:
+            Call(static_cast<ObjClosure *>(callee.AsObj()), argc);
+            return;
+        case ObjType::CLASS:
+        {
+            ObjClass *klass = static_cast<ObjClass *>(callee.AsObj());
+            stack_top[-argc - 1] = Value::FromObj(Allocate<ObjInstance>(klass));
+            if (klass->initializer != nullptr)
+            {
+                Call(klass->initializer, argc);
+            }
+            else if (argc != 0)
+            {
+                ThrowRuntimeError("Expected 0 arguments but got " + std::to_string(argc) + ".");
+            }
+            return;
+        }
+        case ObjType::BOUND_METHOD:
+        {
+            ObjBoundMethod *bound = static_cast<ObjBoundMethod *>(callee.AsObj());
+            stack_top[-argc - 1] = bound->receiver;
+            Call(bound->method, argc);
+            return;
+        }
+        default:
+            break;
+        }
+    }
+    ThrowRuntimeError("Can only call functions and classes.");
+}
+void VM::Call(ObjClosure *closure, int argc)
+{
+    if (argc != closure->function->arity)
+    {
+        ThrowRuntimeError("Expected " + std::to_string(closure->function->arity) + " arguments but got " + std::to_string(argc) + ".");
+    }
+    if (frame_count == FRAMES_MAX)
+    {
+        ThrowRuntimeError("Stack overflow.");
+    }
+
+    CallFrame *frame = &frames[frame_count++];
+    frame->closure = closure;
+    frame->ip = closure->function->chunk.code.data();
+    frame->slots = stack_top - argc - 1;
+
+    GarbageCollector &gc = GarbageCollector::Instance();
+    if (gc.ShouldCollect())
+        gc.Collect();
+}
+void VM::Invoke(ObjString *name, int argc)
+{
+    Value receiver = Peek(argc);
+    if (!IsObjType(receiver, ObjType::INSTANCE))
+        ThrowRuntimeError("Only instances have properties.");
+
+    ObjInstance *instance = static_cast<ObjInstance *>(receiver.AsObj());
+    auto it = instance->fields.find(name);
+    if (it != instance->fields.end())
+    {
+        stack_top[-argc - 1] = it->second;
+        CallValue(it->second, argc);
+        return;
+    }
+    InvokeFromClass(instance->klass, name, argc);
+}
+void VM::InvokeFromClass(ObjClass *klass, ObjString *name, int argc)
+{
+    auto it = klass->methods.find(name);
+    if (it == klass->methods.end())
+        ThrowRuntimeError("Undefined property '" + name->chars + "'.");
+    Call(it->second, argc);
+}
+void VM::BindMethod(ObjClass *klass, ObjString *name)
+{
+    auto it = klass->methods.find(name);
+    if (it == klass->methods.end())
+        ThrowRuntimeError("Undefined property '" + name->chars + "'.");
+
+    ObjBoundMethod *bound = Allocate<ObjBoundMethod>(stack_top[-1], it->second);
+    stack_top[-1] = Value::FromObj(bound);
+}
+ObjUpvalue *VM::CaptureUpvalue(Value *local)
+{
+    ObjUpvalue *previous = nullptr;
+    ObjUpvalue *upvalue = open_upvalues;
+    while (upvalue != nullptr && upvalue->location > local)
+    {
+        previous = upvalue;
+        upvalue = upvalue->next_open;
+    }
+    if (upvalue != nullptr && upvalue->location == local)
+        return upvalue;
+
+    ObjUpvalue *created = Allocate<ObjUpvalue>(local);
+    created->next_open = upvalue;
+    if (previous == nullptr)
+        open_upvalues = created;
+    else
+        previous->next_open = created;
+    return created;
+}
+void VM::CloseUpvalues(Value *last)
+{
+    while (open_upvalues != nullptr && open_upvalues->location >= last)
+    {
+        ObjUpvalue *upvalue = open_upvalues;
+        upvalue->closed = *upvalue->location;
+        upvalue->location = &upvalue->closed;
+        open_upvalues = upvalue->next_open;
+    }
+}
+void VM::DefineMethod(ObjString *name)
+{
+    ObjClosure *method = static_cast<ObjClosure *>(Peek(0).AsObj());
+    ObjClass *klass = static_cast<ObjClass *>(Peek(1).AsObj());
+    klass->methods[name] = method;
+    if (name == init_string)
+        klass->initializer = method;
+    stack_top--;
+}
+void VM::Concatenate()
+{
+    ObjString *b = static_cast<ObjString *>(Peek(0).AsObj());
+    ObjString *a = static_cast<ObjString *>(Peek(1).AsObj());
+    ObjString *result = CopyString(a->chars + b->chars);
+    stack_top -= 2;
+    Push(Value::FromObj(result));
+}
+void VM::ThrowRuntimeError(const std::string &message)
+{
+    CallFrame &frame = frames[frame_count - 1];
+    const Chunk &chunk = frame.closure->function->chunk;
+    size_t offset = frame.ip - chunk.code.data() - 1;
+    throw ::RuntimeError(Token(END_OF_FILE, 0, 0, chunk.lines[offset]), message);
+}
@@ -0,0 +1,86 @@
+/*
+ * vm.h
+ * This file defines the VM class, a stack-based virtual machine that executes the bytecode produced by the Compiler.
+ * It is an alternative to the tree-walking Interpreter: both run the same resolved programs and print the same output.
+ *
+ * The Interpret method runs a compiled top-level script. Runtime errors are reported through Error::ProcessRuntimeError,
+ * exactly like the Interpreter does.
+ *
+ * The CopyString method returns the interned ObjString for some characters, and the New... methods allocate the other objects.
+ * Every object is owned by the garbage collector; the VM is a root source that marks what it can reach and drops unmarked strings
+ * from its intern table.
+ *
+ * Calls push a CallFrame that points into the shared value stack, so arguments are never copied: the callee's parameters are the
+ * argument slots left on the stack by the caller.
+ */
+#ifndef VM_H
+#define VM_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "vm_object.h"
+
+class VM : public GcRootSource
+{
+public:
+    VM();
+    VM(const VM &) = delete;
+    ~VM();
+    // runs a compiled script, reporting any runtime error
+    void Interpret(ObjFunction *script);
+    // returns the interned string with the given characters
+    ObjString *CopyString(std::string_view chars);
+    // allocates an empty function for the compiler to fill in
+    ObjFunction *NewFunction();
+    // marks the stack, the frames' closures, the open upvalues and the globals
+    void MarkRoots(GarbageCollector &gc) override;
+    // removes strings that are about to be freed from the intern table
+    void SweepWeakReferences(GarbageCollector &gc) override;
+
+private:
+    struct CallFrame
+    {
+        ObjClosure *closure;
+        uint8_t *ip;  // the next instruction to execute
+        Value *slots; // the first stack slot of this frame, holding the callee or receiver
+    };
+
+    static const int FRAMES_MAX = 1024;
+    static const int STACK_MAX = FRAMES_MAX * 256;
+
+    Value *stack;
+    Value *stack_top;
+    CallFrame frames[FRAMES_MAX];
+    int frame_count = 0;
+    std::unordered_map<ObjString *, Value> globals;
+    std::unordered_map<std::string_view, ObjString *> strings; // the intern table, keyed by each string's own characters
+    ObjUpvalue *open_upvalues = nullptr;                  // sorted by stack slot, highest first
+    ObjString *init_string;
+
+    template <typename T, typename... Args>
+    T *Allocate(Args &&...args);
+
+    // executes bytecode until the top-level script returns
+    void Run();
+    void Push(Value value) { *stack_top++ = value; }
+    Value Pop() { return *--stack_top; }
+    Value Peek(int distance) { return stack_top[-1 - distance]; }
+    // calls a closure, class or bound method with argc arguments on the stack
+    void CallValue(Value callee, int argc);
+    void Call(ObjClosure *closure, int argc);
+    // calls a method on the receiver sitting below the arguments, without creating a bound method
+    void Invoke(ObjString *name, int argc);
+    void InvokeFromClass(ObjClass *klass, ObjString *name, int argc);
+    // replaces the instance on top of the stack with a bound method
+    void BindMethod(ObjClass *klass, ObjString *name);
+    ObjUpvalue *CaptureUpvalue(Value *local);
+    // closes every open upvalue that points at last or above it
+    void CloseUpvalues(Value *last);
+    void DefineMethod(ObjString *name);
+    void Concatenate();
+    // throws a RuntimeError at the line of the instruction the current frame last saved
+    [[noreturn]] void ThrowRuntimeError(const std::string &message);
+};
+
+#endif // VM_H
@@ -0,0 +1,97 @@
+/*
+ * vm_object.cpp
+ * This file implements the Stringify and MarkValue functions, the Trace methods of the objects declared in vm_object.h, and the Size
+ * method of ObjFunction.
+ *
+ * Numbers are formatted by Interpreter::Stringify so both engines print them identically. Closures and bound methods print as
+ * "function", classes print their name and instances print their class name followed by "instance", matching the tree-walker.
+ *
+ * A function traces its name and the constants of its chunk, an upvalue its closed value (an open upvalue's slot is on the VM stack,
+ * which is a root), a closure its function and upvalues, a class its name and methods, an instance its class and fields, and a bound
+ * method its receiver and method.
+ */
+#include "vm_object.h"
+#include "interpreter.h"
+
+std::string Stringify(Value value)
+{
+    switch (value.type)
+    {
+    case ValueType::NIL:
+        return "nil";
+    case ValueType::BOOL:
+        return value.AsBool() ? "true" : "false";
+    case ValueType::NUMBER:
+        return Interpreter::Stringify(value.AsNumber());
+    case ValueType::OBJ:
+        break;
+    }
+
+    Obj *obj = value.AsObj();
+    switch (obj->type)
+    {
+    case ObjType::STRING:
+        return static_cast<ObjString *>(obj)->chars;
+    case ObjType::CLASS:
+        return static_cast<ObjClass *>(obj)->name->chars;
+    case ObjType::INSTANCE:
+        return static_cast<ObjInstance *>(obj)->klass->name->chars + " instance";
+    case ObjType::FUNCTION:
+    case ObjType::CLOSURE:
+    case ObjType::BOUND_METHOD:
+        return "function";
+    case ObjType::UPVALUE:
+        return "upvalue";
+    }
+    return "";
+}
+
+void MarkValue(GarbageCollector &gc, Value value)
+{
+    if (value.IsObj())
+        gc.Mark(value.AsObj());
+}
+void ObjFunction::Trace(GarbageCollector &gc)
+{
+    gc.Mark(name);
+    for (Value constant : chunk.constants)
+        MarkValue(gc, constant);
+}
+size_t ObjFunction::Size() const
+{
+    return sizeof(ObjFunction) + chunk.code.capacity() * sizeof(chunk.code[0]) + chunk.lines.capacity() * sizeof(chunk.lines[0]) +
+           chunk.constants.capacity() * sizeof(Value);
+}
+void ObjUpvalue::Trace(GarbageCollector &gc)
+{
+    MarkValue(gc, closed);
+}
+void ObjClosure::Trace(GarbageCollector &gc)
+{
+    gc.Mark(function);
+    for (ObjUpvalue *upvalue : upvalues)
+        gc.Mark(upvalue);
+}
+void ObjClass::Trace(GarbageCollector &gc)
+{
+    gc.Mark(name);
+    for (auto it = methods.begin(); it != methods.end(); it++)
+    {
+        gc.Mark(it->first);
+        gc.Mark(it->second);
+    }
+}
+void ObjInstance::Trace(GarbageCollector &gc)
+{
+    gc.Mark(klass);
+    for (auto it = fields.begin(); it != fields.end(); it++)
+    {
+        gc.Mark(it->first);
+        MarkValue(gc, it->second);
+    }
+}
+void ObjBoundMethod::Trace(GarbageCollector &gc)
+{
+    MarkValue(gc, receiver);
+    gc.Mark(method);
+}
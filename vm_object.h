@@ -0,0 +1,137 @@
+/*
+ * vm_object.h
+ * This file defines the heap objects of the bytecode virtual machine. Every object derives from Obj, which records the object's type.
+ * Obj is a GcObject: objects are allocated through the garbage collector and each type traces the objects it references and reports
+ * its size, counting the characters, chunk, upvalue array or map it owns.
+ *
+ * ObjString is an immutable, interned string; two equal strings are always the same ObjString.
+ * ObjFunction is a compiled function prototype: its bytecode chunk, arity, number of upvalues and name.
+ * ObjUpvalue is a captured variable. While open it points at a stack slot; once closed it owns the value itself.
+ * ObjClosure pairs an ObjFunction with the upvalues it captured.
+ * ObjClass holds a class name and its methods, including the ones copied down from its superclass.
+ * ObjInstance holds a reference to its class and a map of fields.
+ * ObjBoundMethod pairs a receiver with a method closure.
+ *
+ * The Stringify function converts a value to the same text the tree-walking Interpreter prints.
+ * The MarkValue function marks the object a value refers to, if any.
+ */
+#ifndef VM_OBJECT_H
+#define VM_OBJECT_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "chunk.h"
+#include "vm_value.h"
+#include "garbage_collector.h"
+
+enum class ObjType
+{
+    STRING,
+    FUNCTION,
+    UPVALUE,
+    CLOSURE,
+    CLASS,
+    INSTANCE,
+    BOUND_METHOD
+};
+
+class Obj : public GcObject
+{
+public:
+    Obj(ObjType type) : type(type) {}
+
+    ObjType type;
+};
+
+class ObjString : public Obj
+{
+public:
+    ObjString(std::string chars) : Obj(ObjType::STRING), chars(std::move(chars)) {}
+    void Trace(GarbageCollector &) override {}
+    size_t Size() const override { return sizeof(ObjString) + chars.size(); }
+
+    const std::string chars;
+};
+
+class ObjFunction : public Obj
+{
+public:
+    ObjFunction() : Obj(ObjType::FUNCTION) {}
+    void Trace(GarbageCollector &gc) override;
+    size_t Size() const override;
+
+    int arity = 0;
+    int upvalue_count = 0;
+    Chunk chunk;
+    ObjString *name = nullptr; // nullptr for the top-level script
+};
+
+class ObjUpvalue : public Obj
+{
+public:
+    ObjUpvalue(Value *slot) : Obj(ObjType::UPVALUE), location(slot) {}
+    void Trace(GarbageCollector &gc) override;
+    size_t Size() const override { return sizeof(ObjUpvalue); }
+
+    Value *location;                  // the stack slot while open, &closed once closed
+    Value closed = Value::Nil();      // the captured value after the slot has left the stack
+    ObjUpvalue *next_open = nullptr; // the next open upvalue further down the stack
+};
+
+class ObjClosure : public Obj
+{
+public:
+    ObjClosure(ObjFunction *function) : Obj(ObjType::CLOSURE), function(function), upvalues(function->upvalue_count, nullptr) {}
+    void Trace(GarbageCollector &gc) override;
+    size_t Size() const override { return sizeof(ObjClosure) + upvalues.capacity() * sizeof(ObjUpvalue *); }
+
+    ObjFunction *function;
+    std::vector<ObjUpvalue *> upvalues;
+};
+
+class ObjClass : public Obj
+{
+public:
+    ObjClass(ObjString *name) : Obj(ObjType::CLASS), name(name) {}
+    void Trace(GarbageCollector &gc) override;
+    size_t Size() const override { return sizeof(ObjClass) + MapSize(methods); }
+
+    ObjString *name;
+    std::unordered_map<ObjString *, ObjClosure *> methods;
+    ObjClosure *initializer = nullptr; // the "init" method, looked up once when it is defined or inherited
+};
+
+class ObjInstance : public Obj
+{
+public:
+    ObjInstance(ObjClass *klass) : Obj(ObjType::INSTANCE), klass(klass) {}
+    void Trace(GarbageCollector &gc) override;
+    size_t Size() const override { return sizeof(ObjInstance) + MapSize(fields); }
+
+    ObjClass *klass;
+    std::unordered_map<ObjString *, Value> fields;
+};
+
+class ObjBoundMethod : public Obj
+{
+public:
+    ObjBoundMethod(Value receiver, ObjClosure *method) : Obj(ObjType::BOUND_METHOD), receiver(receiver), method(method) {}
+    void Trace(GarbageCollector &gc) override;
+    size_t Size() const override { return sizeof(ObjBoundMethod); }
+
+    Value receiver;
+    ObjClosure *method;
+};
+
+inline bool IsObjType(Value value, ObjType type)
+{
+    return value.IsObj() && value.AsObj()->type == type;
+}
+
+// converts a value to the text printed by a print statement
+std::string Stringify(Value value);
+// marks the object a value refers to; numbers, booleans and nil hold nothing
+void MarkValue(GarbageCollector &gc, Value value);
+
+#endif // VM_OBJECT_H
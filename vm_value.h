@@ -0,0 +1,98 @@
+/*
+ * vm_value.h
+ * This file defines the Value struct, which is the runtime representation of a Lox value inside the bytecode virtual machine.
+ * A Value is a small tagged union holding nil, a boolean, a number, or a pointer to a heap object (Obj).
+ * Like the Object of the tree-walking Interpreter, a Value never owns a std::string, so copying one is a plain register move.
+ *
+ * The static Nil, Bool, Number and FromObj methods build values, and the Is.../As... methods test and unwrap them.
+ * ValuesEqual implements Lox equality, and IsFalsey implements Lox truthiness.
+ */
+#ifndef VM_VALUE_H
+#define VM_VALUE_H
+
+class Obj;
+
+enum class ValueType
+{
+    NIL,
+    BOOL,
+    NUMBER,
+    OBJ
+};
+
+struct Value
+{
+    ValueType type;
+    union
+    {
+        bool boolean;
+        double number;
+        Obj *obj;
+    } as;
+
+    static Value Nil()
+    {
+        Value value;
+        value.type = ValueType::NIL;
+        value.as.number = 0;
+        return value;
+    }
+    static Value Bool(bool boolean)
+    {
+        Value value;
+        value.type = ValueType::BOOL;
+        value.as.boolean = boolean;
+        return value;
+    }
+    static Value Number(double number)
+    {
+        Value value;
+        value.type = ValueType::NUMBER;
+        value.as.number = number;
+        return value;
+    }
+    static Value FromObj(Obj *obj)
+    {
+        Value value;
+        value.type = ValueType::OBJ;
+        value.as.obj = obj;
+        return value;
+    }
+
+    bool IsNil() const { return type == ValueType::NIL; }
+    bool IsBool() const { return type == ValueType::BOOL; }
+    bool IsNumber() const { return type == ValueType::NUMBER; }
+    bool IsObj() const { return type == ValueType::OBJ; }
+
+    bool AsBool() const { return as.boolean; }
+    double AsNumber() const { return as.number; }
+    Obj *AsObj() const { return as.obj; }
+};
+
+// nil and false are falsey, everything else is truthy
+inline bool IsFalsey(Value value)
+{
+    return value.IsNil() || (value.IsBool() && !value.AsBool());
+}
+
+// strings are interned by the VM, so every kind of object compares by identity
+inline bool ValuesEqual(Value a, Value b)
+{
+    if (a.type != b.type)
+        return false;
+
+    switch (a.type)
+    {
+    case ValueType::NIL:
+        return true;
+    case ValueType::BOOL:
+        return a.AsBool() == b.AsBool();
+    case ValueType::NUMBER:
+        return a.AsNumber() == b.AsNumber();
+    case ValueType::OBJ:
+        return a.AsObj() == b.AsObj();
+    }
+    return false;
+}
+
+#endif // VM_VALUE_H